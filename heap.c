@@ -1,1528 +1,3246 @@
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/mman.h>
 #include "heap.h"
 #include "custom_unistd.h"
 
-#define size_ch 32
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define size_ch 16
 #define PAGE 4096
 #define FENCE 16
+#define ALIGN 16
+
+// flagi w najniższych bitach span
+#define CHUNK_FREE 1u
+#define CHUNK_FLAGS (ALIGN - 1u)
+#define CHUNK_MAX_SPAN 0xFFFFFFF0u
+
+// najmniejsza reszta, jaka zostaje oddzielona jako osobny wolny blok
+#define SPLIT_MIN 64
+
+#if !defined(HEAP_DEFAULT_INTEGRITY)
+#if defined(NDEBUG)
+#define HEAP_DEFAULT_INTEGRITY heap_integrity_free
+#else
+#define HEAP_DEFAULT_INTEGRITY heap_integrity_full
+#endif
+#endif
+
+#if !defined(HEAP_SUM_SEED)
+#define HEAP_SUM_SEED 0x6A09E667F3BCC908ULL
+#endif
+
+// od tego rozmiaru heap_calloc zeruje zapisem omijającym pamięć podręczną
+#if !defined(HEAP_STREAM_THRESHOLD)
+#define HEAP_STREAM_THRESHOLD ((size_t)256 << 10)
+#endif
+
+#if !defined(HEAP_DEFAULT_SAMPLE_PERIOD)
+#define HEAP_DEFAULT_SAMPLE_PERIOD 64
+#endif
+
+// liczba bloków na klasę w pamięci podręcznej wątku, 0 wyłącza
+#if !defined(HEAP_DEFAULT_TCACHE)
+#if defined(NDEBUG)
+#define HEAP_DEFAULT_TCACHE 16
+#else
+#define HEAP_DEFAULT_TCACHE 0
+#endif
+#endif
+
+// liczba aren, między które rozdzielane są wątki; 1 - wszystkie używają głównej
+#if !defined(HEAP_DEFAULT_ARENAS)
+#if defined(NDEBUG)
+#define HEAP_DEFAULT_ARENAS 4
+#else
+#define HEAP_DEFAULT_ARENAS 1
+#endif
+#endif
+
+// rezerwacja przestrzeni adresowej dodatkowej areny
+#if !defined(HEAP_ARENA_RESERVE)
+#define HEAP_ARENA_RESERVE ((size_t)64 << 20)
+#endif
+
+// małe obiekty ze slabów zamiast z listy bloków
+#if !defined(HEAP_DEFAULT_SLAB)
+#if defined(NDEBUG)
+#define HEAP_DEFAULT_SLAB 1
+#else
+#define HEAP_DEFAULT_SLAB 0
+#endif
+#endif
+
+// bloki od tego rozmiaru poza stertą, w osobnych mapowaniach; 0 wyłącza
+#if !defined(HEAP_DEFAULT_MMAP_THRESHOLD)
+#if defined(NDEBUG)
+#define HEAP_DEFAULT_MMAP_THRESHOLD ((size_t)256 << 10)
+#else
+#define HEAP_DEFAULT_MMAP_THRESHOLD 0
+#endif
+#endif
+
+// automatyczne oddawanie końca sterty: próg i zapas, który zostaje, żeby nie oddawać i pobierać na przemian
+#if !defined(HEAP_DEFAULT_TRIM_THRESHOLD)
+#define HEAP_DEFAULT_TRIM_THRESHOLD ((size_t)128 << 10)
+#endif
+
+#if !defined(HEAP_DEFAULT_TRIM_PAD)
+#define HEAP_DEFAULT_TRIM_PAD ((size_t)64 << 10)
+#endif
+
+// przyrost sterty: podwojenie obecnego rozmiaru w tych granicach, żeby rzadko wołać custom_sbrk
+#if !defined(HEAP_DEFAULT_GROW_MIN)
+#define HEAP_DEFAULT_GROW_MIN ((size_t)64 << 10)
+#endif
+
+#if !defined(HEAP_DEFAULT_GROW_MAX)
+#define HEAP_DEFAULT_GROW_MAX ((size_t)1 << 20)
+#endif
+
+// domyślny rozmiar kawałka pamięci regionu (heap_arena_create)
+#if !defined(HEAP_REGION_CHUNK)
+#define HEAP_REGION_CHUNK ((size_t)64 << 10)
+#endif
+
+// rezerwacja przestrzeni adresowej na strony slabów jednej areny
+#if !defined(HEAP_SLAB_RESERVE)
+#define HEAP_SLAB_RESERVE ((size_t)64 << 20)
+#endif
+
+// zasięg mapy stron od początku areny; wskaźniki dalej klasyfikowane są przejściem po liście bloków
+#if !defined(HEAP_PAGE_MAP_RANGE)
+#define HEAP_PAGE_MAP_RANGE HEAP_ARENA_RESERVE
+#endif
+
+#define PAGE_MAP_PAGES (HEAP_PAGE_MAP_RANGE / PAGE)
+
+#define SLAB_MAX_SIZE (HEAP_SLAB_CLASSES * ALIGN)
+#define SLAB_MAP_WORDS 4
+
+#define TCACHE_MAX_SIZE 512
+#define TCACHE_BINS (TCACHE_MAX_SIZE / 16)
+
+struct memory_manager_t memory_manager;
+_Thread_local enum pointer_type_t typ_pointer;
+
+// Ustawienia przeżywają heap_setup i heap_clean
+static struct heap_options_t
+{
+    enum heap_integrity_t integrity;
+    size_t sample_period;
+    size_t tcache_count;
+    size_t arena_count;
+    int slab;
+    enum heap_engine_t engine;
+    size_t mmap_threshold;
+    size_t trim_threshold;
+    size_t trim_pad;
+    size_t grow_min;
+    size_t grow_max;
+    size_t histogram;
+} heap_options = { HEAP_DEFAULT_INTEGRITY, HEAP_DEFAULT_SAMPLE_PERIOD, HEAP_DEFAULT_TCACHE, HEAP_DEFAULT_ARENAS, HEAP_DEFAULT_SLAB, heap_engine_default,
+                   HEAP_DEFAULT_MMAP_THRESHOLD, HEAP_DEFAULT_TRIM_THRESHOLD, HEAP_DEFAULT_TRIM_PAD,
+                   HEAP_DEFAULT_GROW_MIN, HEAP_DEFAULT_GROW_MAX, 0 };
+
+// silnik wybrany przy ostatnim heap_setup
+static enum heap_engine_t heap_engine;
+
+static _Thread_local size_t sample_count;
+
+// ostatni przydzielony blok pochodzi z pamięci, która nie była jeszcze zapisana - heap_calloc nie musi jej zerować
+static _Thread_local int block_zero;
+
+//
+// Areny: każda ma własny stan i własną blokadę. Arena 0 to memory_manager z pamięcią z custom_sbrk,
+// pozostałe rezerwują przestrzeń przez mmap. Blokada areny 0 chroni też ustawienia i heap_generation,
+// które zmienia się przy heap_setup i heap_clean.
+// Bloki zwalniane przez wątki innych aren trafiają bez blokady na stos remote_free (wielu producentów,
+// jeden konsument), który arena opróżnia w całości przy najbliższej alokacji.
+struct tcache_entry_t;
+
+struct arena_t
+{
+    struct memory_manager_t* manager;
+    pthread_mutex_t lock;
+    struct tcache_entry_t* remote_free;
+};
+
+static struct memory_manager_t arena_memory[HEAP_MAX_ARENAS - 1];
+
+#define ARENA(m) { m, PTHREAD_MUTEX_INITIALIZER, NULL }
+_Static_assert(HEAP_MAX_ARENAS == 8, "lista aren poniżej");
+static struct arena_t arenas[HEAP_MAX_ARENAS] = {
+    ARENA(&memory_manager), ARENA(&arena_memory[0]), ARENA(&arena_memory[1]), ARENA(&arena_memory[2]),
+    ARENA(&arena_memory[3]), ARENA(&arena_memory[4]), ARENA(&arena_memory[5]), ARENA(&arena_memory[6])
+};
+
+static uint64_t heap_generation;
+static unsigned arena_next;
+static _Thread_local int thread_arena = -1;
+
+// Arena, której blokadę trzyma bieżący wątek; na niej działają wszystkie funkcje chunk_ i bin_
+static _Thread_local struct memory_manager_t* manager;
+
+//
+// Pamięć podręczna wątku (tcache): zajęte bloki o rozmiarze klasy, połączone przez pierwsze słowo danych.
+// Drugie słowo oznacza blok jako leżący w pamięci podręcznej (wykrycie podwójnego zwolnienia).
+struct tcache_entry_t
+{
+    struct tcache_entry_t* next;
+    const void* key;
+};
+
+struct heap_tcache_t
+{
+    struct tcache_entry_t* bins[TCACHE_BINS];
+    uint32_t count[TCACHE_BINS];
+    uint64_t generation;
+    int registered;
+};
+
+static _Thread_local struct heap_tcache_t tcache;
+static pthread_key_t tcache_key;
+static pthread_once_t tcache_once = PTHREAD_ONCE_INIT;
+static const char tcache_mark;
+static const char remote_mark;
+
+// rodzaje bloków śledzonych przez heap_maxima_t
+enum { MAXIMA_USED, MAXIMA_FREE };
+
+static enum pointer_type_t pointer_type(const void* pointer);
+static int validate_heap(void);
+static void chunk_account(int kind, const struct memory_chunk_t* block, int add);
+
+// Wolny blok przechowuje wskaźniki listy swojego koszyka zaraz za nagłówkiem
+struct free_links_t
+{
+    struct memory_chunk_t* prev_free;
+    struct memory_chunk_t* next_free;
+} __attribute__(( packed ));
+
+#define size_links ((int)sizeof(struct free_links_t))
+
+size_t align_size(size_t size){
+    return (size + PAGE -1) & ~(size_t)(PAGE -1);
+}
+
+static size_t align16(size_t size)
+{
+    return (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+}
+
+// alignment jest potęgą dwójki
+static size_t align_to(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t chunk_span(const struct memory_chunk_t* block)
+{
+    return block->span & ~CHUNK_FLAGS;
+}
+
+static int chunk_free(const struct memory_chunk_t* block)
+{
+    return (block->span & CHUNK_FREE) != 0;
+}
+
+// Płotek za danymi wydłuża się o wyrównanie do 16 bajtów
+static size_t fence_after(size_t size)
+{
+    return FENCE + align16(size) - size;
+}
+
+static size_t chunk_need(size_t size)
+{
+    return size_ch + FENCE + align16(size) + FENCE;
+}
+
+//
+// Suma kontrolna: XOR składników liczonych osobno dla każdego pola nagłówka,
+// dzięki czemu zmianę jednego pola można nanieść bez liczenia całości
+enum sum_field_t { sum_prev_size, sum_span, sum_size };
+
+#if defined(__x86_64__)
+// CRC32C kompilowane dla SSE4.2 niezależnie od flag budowania; bez -msse4.2 wybór zapada w heap_setup.
+// CRC jest liniowe, więc wartość z kluczem pola najpierw przechodzi przez mnożenie - inaczej zamiana wartości
+// dwóch pól lub zmiany znoszące się w XOR dawałyby tę samą sumę, a jeden poprawny nagłówek zdradzałby klucz
+__attribute__(( target("sse4.2") ))
+static uint32_t sum_crc(uint64_t key, uint64_t value)
+{
+    return (uint32_t)_mm_crc32_u64((uint32_t)(key >> 32), (value ^ key) * 0xFF51AFD7ED558CCDULL);
+}
+#endif
+
+#if defined(__x86_64__) && !defined(__SSE4_2__)
+static int sum_crc_enabled;
+#endif
+
+static uint32_t sum_term(uint64_t sum_key, enum sum_field_t field, uint64_t value)
+{
+    uint64_t key = sum_key + (uint64_t)(field + 1) * 0x9E3779B97F4A7C15ULL;
+#if defined(__SSE4_2__)
+    return sum_crc(key, value);
+#else
+#if defined(__x86_64__)
+    if(sum_crc_enabled)
+        return sum_crc(key, value);
+#endif
+    uint64_t h = (value ^ key) * 0xFF51AFD7ED558CCDULL;
+    return (uint32_t)(h ^ (h >> 32));
+#endif
+}
+
+// Klucz sumy zależy od areny, więc liczy się ją względem areny bieżącego wątku
+static int chunk_sum(const struct memory_chunk_t* block, uint64_t sum_key)
+{
+    uint32_t s = sum_term(sum_key, sum_prev_size, block->prev_size);
+    s ^= sum_term(sum_key, sum_span, block->span);
+    s ^= sum_term(sum_key, sum_size, block->size);
+    return (int)s;
+}
+
+static void set_sum_control(struct memory_chunk_t* block)
+{
+    block->sum_control = 0;
+    block->sum_control = chunk_sum(block, manager->sum_key);
+}
+
+static void update_sum_control(struct memory_chunk_t* block, enum sum_field_t field, uint64_t old_value, uint64_t new_value)
+{
+    block->sum_control ^= (int)(sum_term(manager->sum_key, field, old_value) ^ sum_term(manager->sum_key, field, new_value));
+}
+
+static struct free_links_t* free_links(struct memory_chunk_t* block)
+{
+    return (struct free_links_t*)((uint8_t*)block + size_ch);
+}
+
+//
+// Koszyki wolnych bloków: do 256 bajtów co 16, dalej 4 klasy na każdą potęgę dwójki
+static int bin_index(size_t size)
+{
+    // obie gałęzie liczone zawsze i wybierane bez skoku - rozmiary po obu stronach 256 zwykle się przeplatają;
+    // bit 256 trzyma fl >= 8, więc gałąź dużych rozmiarów nie przesuwa liczby ujemnej
+    int fl = 63 - __builtin_clzll(size | 256);
+    int index = 16 + ((fl - 8) << 2) + (int)((size >> (fl - 2)) & 3);
+    if(index >= HEAP_BIN_COUNT)
+        index = HEAP_BIN_COUNT - 1;
+    int small = -(int)(size < 256);
+    return (index & ~small) | ((int)(size >> 4) & small);
+}
+
+// Najniższy koszyk, w którym każdy blok mieści size
+static int bin_index_up(size_t size)
+{
+    if(size < 256)
+        return (int)((size + ALIGN - 1) >> 4);
+    int fl = 63 - __builtin_clzll(size);
+    return bin_index(size + ((size_t)1 << (fl - 2)) - 1);
+}
+
+static int bin_next(int index)
+{
+    for(int word = index >> 6; word < HEAP_BIN_COUNT / 64; word++){
+        uint64_t map = manager->bin_map[word];
+        if(word == index >> 6)
+            map &= ~(uint64_t)0 << (index & 63);
+        if(map)
+            return (word << 6) + __builtin_ctzll(map);
+    }
+    return -1;
+}
+
+static void bin_insert(struct memory_chunk_t* block)
+{
+    int index = bin_index(block->size);
+    struct free_links_t* links = free_links(block);
+    links->prev_free = NULL;
+    links->next_free = manager->bins[index];
+    if(links->next_free)
+        free_links(links->next_free)->prev_free = block;
+    manager->bins[index] = block;
+    manager->bin_map[index >> 6] |= (uint64_t)1 << (index & 63);
+    chunk_account(MAXIMA_FREE, block, 1);
+}
+
+static void bin_remove(struct memory_chunk_t* block)
+{
+    int index = bin_index(block->size);
+    struct free_links_t* links = free_links(block);
+    if(links->prev_free)
+        free_links(links->prev_free)->next_free = links->next_free;
+    else
+        manager->bins[index] = links->next_free;
+    if(links->next_free)
+        free_links(links->next_free)->prev_free = links->prev_free;
+    if(manager->bins[index] == NULL)
+        manager->bin_map[index >> 6] &= ~((uint64_t)1 << (index & 63));
+    chunk_account(MAXIMA_FREE, block, 0);
+}
+
+static struct memory_chunk_t* bin_find(size_t size)
+{
+    if(heap_engine == heap_engine_tlsf){
+        int index = bin_next(bin_index_up(size));
+        if(index < 0)
+            return NULL;
+        return manager->bins[index];
+    }
+
+    int index = bin_index(size);
+    struct memory_chunk_t* block = manager->bins[index];
+    while(block){
+        if(block->size >= size)
+            return block;
+        block = free_links(block)->next_free;
+    }
+    // w każdym wyższym koszyku wystarczy pierwszy blok
+    index = bin_next(index + 1);
+    if(index < 0)
+        return NULL;
+    return manager->bins[index];
+}
+
+//
+// Lista bloków - sąsiedzi wyznaczani z span i prev_size
+static struct memory_chunk_t* chunk_next(const struct memory_chunk_t* block)
+{
+    if(block == manager->last_memory_chunk)
+        return NULL;
+    return (struct memory_chunk_t*)((uint8_t*)block + chunk_span(block));
+}
+
+static struct memory_chunk_t* chunk_prev(const struct memory_chunk_t* block)
+{
+    if(block->prev_size == 0)
+        return NULL;
+    return (struct memory_chunk_t*)((uint8_t*)block - block->prev_size);
+}
+
+static uint8_t* heap_tail(void)
+{
+    struct memory_chunk_t *last = manager->last_memory_chunk;
+    if(last == NULL)
+        return (uint8_t*)manager->memory_start;
+    return (uint8_t*)last + chunk_span(last);
+}
+
+//
+// Mapa stron: dla każdej strony pierwszy początek bloku leżący na niej oraz zajęty blok, którego dane
+// z płotkami obejmują początek strony. Wartości to przesunięcie od początku areny + 1, 0 oznacza brak.
+struct heap_page_t
+{
+    uint32_t first;
+    uint32_t used;
+};
+
+//
+// Największe bloki (zajęte i wolne) do odczytu w czasie stałym. Rozmiary poniżej strony mają dokładne
+// liczniki z dwupoziomową mapą bitów. Blok o rozmiarze od strony w górę jest dłuższy niż strona, więc
+// na jednej stronie zaczyna się co najwyżej jeden taki - trafia do liścia drzewa turniejowego tej strony.
+// Bloki poza zasięgiem mapy są tylko liczone; wtedy rozmiar ustala przejście po blokach.
+struct heap_maxima_t
+{
+    uint32_t count[2][PAGE];
+    uint64_t map[2][PAGE / 64];
+    uint64_t summary[2];
+    size_t untracked[2];
+    uint32_t tree[2][2 * PAGE_MAP_PAGES];
+};
+
+#define PAGE_MAP_LENGTH (PAGE_MAP_PAGES * sizeof(struct heap_page_t) + sizeof(struct heap_maxima_t))
+
+static void page_map_create(struct memory_manager_t* arena)
+{
+    void *map = mmap(NULL, PAGE_MAP_LENGTH, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    arena->page_map = map == MAP_FAILED ? NULL : map;
+    arena->maxima = map == MAP_FAILED ? NULL : (struct heap_maxima_t*)(arena->page_map + PAGE_MAP_PAGES);
+}
+
+static void page_map_unmap(struct memory_manager_t* arena)
+{
+    if(arena->page_map != NULL)
+        munmap(arena->page_map, PAGE_MAP_LENGTH);
+    arena->page_map = NULL;
+    arena->maxima = NULL;
+}
+
+static uint32_t page_ref(const struct memory_chunk_t* block)
+{
+    return (uint32_t)((const uint8_t*)block - (uint8_t*)manager->memory_start) + 1;
+}
+
+static struct memory_chunk_t* page_block(uint32_t ref)
+{
+    if(ref == 0)
+        return NULL;
+    return (struct memory_chunk_t*)((uint8_t*)manager->memory_start + ref - 1);
+}
+
+// NULL poza zasięgiem mapy
+static struct heap_page_t* page_entry(const void* pointer)
+{
+    if(manager->page_map == NULL)
+        return NULL;
+    size_t page = (size_t)((const uint8_t*)pointer - (uint8_t*)manager->memory_start) / PAGE;
+    return page < PAGE_MAP_PAGES ? &manager->page_map[page] : NULL;
+}
+
+// Nowy początek bloku
+static void page_first_add(const struct memory_chunk_t* block)
+{
+    struct heap_page_t *page = page_entry(block);
+    if(page != NULL && (page->first == 0 || page_ref(block) < page->first))
+        page->first = page_ref(block);
+}
+
+// Początek bloku znika; next to najbliższy dalszy początek bloku albo NULL
+static void page_first_remove(const struct memory_chunk_t* block, const struct memory_chunk_t* next)
+{
+    manager->version++;
+    struct heap_page_t *page = page_entry(block);
+    if(page == NULL || page->first != page_ref(block))
+        return;
+    page->first = next != NULL && page_entry(next) == page ? page_ref(next) : 0;
+}
+
+// Strony zaczynające się w [from, to) wskazują zajęty blok albo nic dla block == NULL
+static void page_used_set(const uint8_t* from, const uint8_t* to, const struct memory_chunk_t* block)
+{
+    if(manager->page_map == NULL || from >= to)
+        return;
+    size_t first = ((size_t)(from - (uint8_t*)manager->memory_start) + PAGE - 1) / PAGE;
+    size_t last = ((size_t)(to - (uint8_t*)manager->memory_start) + PAGE - 1) / PAGE;
+    if(last > PAGE_MAP_PAGES)
+        last = PAGE_MAP_PAGES;
+    uint32_t ref = block != NULL ? page_ref(block) : 0;
+    for(size_t page = first; page < last; page++)
+        manager->page_map[page].used = ref;
+}
+
+// Rozmiar poniżej strony przybywa (add) albo ubywa
+static void maxima_count(int kind, size_t value, int add)
+{
+    struct heap_maxima_t *maxima = manager->maxima;
+    if(maxima == NULL)
+        return;
+    uint64_t bit = (uint64_t)1 << (value & 63);
+    uint64_t *word = &maxima->map[kind][value >> 6];
+    if(add){
+        if(maxima->count[kind][value]++ == 0){
+            *word |= bit;
+            maxima->summary[kind] |= (uint64_t)1 << (value >> 6);
+        }
+    }
+    else if(--maxima->count[kind][value] == 0){
+        *word &= ~bit;
+        if(*word == 0)
+            maxima->summary[kind] &= ~((uint64_t)1 << (value >> 6));
+    }
+}
+
+// Blok o rozmiarze block->size zaczyna (add) albo kończy bycie zajętym lub wolnym
+static void maxima_update(int kind, const struct memory_chunk_t* block, int add)
+{
+    struct heap_maxima_t *maxima = manager->maxima;
+    if(maxima == NULL)
+        return;
+    if(block->size < PAGE){
+        maxima_count(kind, block->size, add);
+        return;
+    }
+    struct heap_page_t *page = page_entry(block);
+    if(page == NULL){
+        maxima->untracked[kind] += add ? 1 : (size_t)-1;
+        return;
+    }
+    uint32_t *tree = maxima->tree[kind];
+    size_t node = PAGE_MAP_PAGES + (size_t)(page - manager->page_map);
+    tree[node] = add ? block->size : 0;
+    for(; node > 1; node >>= 1){
+        uint32_t up = tree[node] > tree[node ^ 1] ? tree[node] : tree[node ^ 1];
+        if(tree[node >> 1] == up)
+            break;
+        tree[node >> 1] = up;
+    }
+}
+
+// Blok staje się zajęty lub wolny (add) albo przestaje nim być: liczniki heap_get_stats i maksima
+static void chunk_account(int kind, const struct memory_chunk_t* block, int add)
+{
+    size_t fences = FENCE + fence_after(block->size);
+    if(add){
+        manager->chunk_count[kind]++;
+        manager->chunk_bytes[kind] += block->size;
+        if(kind == MAXIMA_USED)
+            manager->fence_bytes += fences;
+    }
+    else {
+        manager->chunk_count[kind]--;
+        manager->chunk_bytes[kind] -= block->size;
+        if(kind == MAXIMA_USED)
+            manager->fence_bytes -= fences;
+    }
+    maxima_update(kind, block, add);
+}
+
+// Największy rozmiar danego rodzaju; -1 gdy część bloków jest poza zasięgiem mapy
+static intptr_t maxima_largest(int kind)
+{
+    struct heap_maxima_t *maxima = manager->maxima;
+    if(maxima == NULL || maxima->untracked[kind] != 0)
+        return -1;
+    if(maxima->tree[kind][1] != 0)
+        return maxima->tree[kind][1];
+    if(maxima->summary[kind] == 0)
+        return 0;
+    int word = 63 - __builtin_clzll(maxima->summary[kind]);
+    return word * 64 + 63 - __builtin_clzll(maxima->map[kind][word]);
+}
+
+static int heap_reserve(const uint8_t* start, size_t length)
+{
+    uint8_t *brk = (uint8_t*)manager->memory_start + manager->memory_size;
+    // span bloku mieści się w 32 bitach
+    if(length > CHUNK_MAX_SPAN || (size_t)(start - (uint8_t*)manager->memory_start) + length > CHUNK_MAX_SPAN)
+        return -1;
+    intptr_t need = (intptr_t)(start - brk) + (intptr_t)length;
+    if(need <= 0)
+        return 0;
+    size_t siz_need = align_size(need);
+    // koniec sterty to memory_start + memory_size, custom_sbrk(0) nie jest potrzebne
+    size_t step = manager->memory_size;
+    if(step < heap_options.grow_min)
+        step = heap_options.grow_min;
+    if(step > heap_options.grow_max)
+        step = heap_options.grow_max;
+    size_t siz_grow = align_size(step);
+    if(siz_grow < siz_need || (size_t)(brk - (uint8_t*)manager->memory_start) + siz_grow > CHUNK_MAX_SPAN)
+        siz_grow = siz_need;
+
+    if(manager->memory_reserved != 0){
+        // arena z mmap rośnie tylko w granicach swojej rezerwacji
+        if(manager->memory_size + siz_grow > manager->memory_reserved)
+            siz_grow = siz_need;
+        if(manager->memory_size + siz_grow > manager->memory_reserved)
+            return -1;
+    }
+    else if(custom_sbrk(siz_grow) == (void*)-1){
+        // zapas się nie zmieścił, próba tylko z brakującą częścią
+        siz_grow = siz_need;
+        if(custom_sbrk(siz_grow) == (void*)-1)
+            return -1;
+    }
+    siz_need = siz_grow;
+    // próg oddawania rośnie z przyrostem, ale nie ponad grow_max - inaczej po jednym dużym bloku
+    // wolny koniec sterty nigdy by go nie przekroczył
+    size_t step_max = align_size(heap_options.grow_max);
+    manager->memory_step = siz_grow > length ? siz_grow : align_size(length);
+    if(manager->memory_step > step_max)
+        manager->memory_step = step_max;
+    // memory_size czytane jest bez blokady w arena_of
+    __atomic_fetch_add(&manager->memory_size, siz_need, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Oddanie pamięci za ostatnim blokiem z zapasem pad; liczba oddanych bajtów
+static size_t heap_trim_locked(size_t pad)
+{
+    uint8_t *start = (uint8_t*)manager->memory_start;
+    if(start == NULL)
+        return 0;
+    size_t used = (size_t)(heap_tail() - start);
+    size_t keep = align_size(used + pad);
+    if(keep < PAGE)
+        keep = PAGE;
+    if(keep >= manager->memory_size)
+        return 0;
+
+    size_t release = manager->memory_size - keep;
+    if(manager->memory_reserved != 0){
+        madvise(start + keep, release, MADV_DONTNEED); // rezerwacja areny zostaje, strony wracają do systemu
+        if(manager->memory_zero > keep)
+            manager->memory_zero = keep;
+    }
+    else if(custom_sbrk(-(intptr_t)release) == (void*)-1)
+        return 0;
+    __atomic_fetch_sub(&manager->memory_size, release, __ATOMIC_RELEASE);
+    return release;
+}
+
+// Nowy span bloku; następny blok dostaje zgodny prev_size
+static void chunk_set_span(struct memory_chunk_t* block, size_t span)
+{
+    block->span = (uint32_t)span | (block->span & CHUNK_FLAGS);
+    set_sum_control(block);
+
+    struct memory_chunk_t *next = chunk_next(block);
+    if(next){
+        update_sum_control(next, sum_prev_size, next->prev_size, span);
+        next->prev_size = (uint32_t)span;
+    }
+}
+
+static void chunk_use(struct memory_chunk_t* block, size_t size)
+{
+    if(!chunk_free(block))
+        chunk_account(MAXIMA_USED, block, 0);
+    uint8_t *used_end = chunk_free(block) ? (uint8_t*)block : (uint8_t*)block + chunk_need(block->size);
+    uint8_t *need_end = (uint8_t*)block + chunk_need(size);
+    if(need_end > used_end)
+        page_used_set(used_end, need_end, block);
+    else
+        page_used_set(need_end, used_end, NULL);
+
+    // tylko mmap daje wyzerowane strony; custom_sbrk oddaje pamięć w stanie, w jakim ją zostawiono
+    block_zero = 0;
+    if(manager->memory_reserved != 0){
+        size_t offset = (size_t)((uint8_t*)block - (uint8_t*)manager->memory_start);
+        block_zero = offset >= manager->memory_zero;
+        if(offset + chunk_span(block) > manager->memory_zero)
+            manager->memory_zero = offset + chunk_span(block);
+    }
+
+    block->size = (uint32_t)size;
+    block->span &= ~CHUNK_FREE;
+    memset((uint8_t*)block + size_ch,'#', FENCE);
+    memset((uint8_t*)block + size_ch + FENCE + size,'#', fence_after(size));
+    set_sum_control(block);
+    chunk_account(MAXIMA_USED, block, 1);
+}
+
+static struct memory_chunk_t* chunk_append(uint8_t* start, size_t size)
+{
+    if(heap_reserve(start, chunk_need(size)) != 0)
+        return NULL;
+    struct memory_chunk_t *last = manager->last_memory_chunk;
+    struct memory_chunk_t *block = (struct memory_chunk_t*)start;
+    block->prev_size = 0;
+    if(last){
+        // przerwa przed nowym blokiem zostaje nieużywaną przestrzenią poprzednika
+        uint32_t span = (uint32_t)(start - (uint8_t*)last) | (last->span & CHUNK_FLAGS);
+        update_sum_control(last, sum_span, last->span, span);
+        last->span = span;
+        block->prev_size = (uint32_t)chunk_span(last);
+    }
+    else
+        manager->first_memory_chunk = block;
+    manager->last_memory_chunk = block;
+    block->span = (uint32_t)chunk_need(size) | CHUNK_FREE;
+    page_first_add(block);
+    chunk_use(block, size);
+    return block;
+}
+
+// Oddzielenie nadmiaru za płotkiem jako nowego wolnego bloku
+static void chunk_split(struct memory_chunk_t* block)
+{
+    size_t need = chunk_need(block->size);
+    size_t rest = chunk_span(block) - need;
+    if(rest < SPLIT_MIN)
+        return;
+    if(block == manager->last_memory_chunk){
+        chunk_set_span(block, need);
+        return;
+    }
+
+    block->span = (uint32_t)need | (block->span & CHUNK_FLAGS);
+    set_sum_control(block);
+
+    struct memory_chunk_t *free_block = (struct memory_chunk_t*)((uint8_t*)block + need);
+    free_block->prev_size = (uint32_t)need;
+    free_block->span = CHUNK_FREE;
+    free_block->size = (uint32_t)(rest - size_ch);
+    chunk_set_span(free_block, rest);
+    page_first_add(free_block);
+    bin_insert(free_block);
+}
+
+// Zmiana rozmiaru bloku bez przenoszenia danych; -1 gdy w miejscu się nie da.
+// Zwolniony ogon staje się wolnym blokiem, połączonym z wolnym następnikiem.
+static int chunk_resize(struct memory_chunk_t* block, size_t size)
+{
+    if(size == block->size)
+        return 0;
+
+    size_t need = chunk_need(size);
+    struct memory_chunk_t *next = chunk_next(block);
+    if(next && chunk_free(next) && chunk_span(block) + chunk_span(next) >= need){ // AaaaaB.... po AaaaaaaaB
+        bin_remove(next);
+        chunk_set_span(block, chunk_span(block) + chunk_span(next));
+        page_first_remove(next, chunk_next(block));
+    }
+    else if(need > chunk_span(block)){
+        if(next != NULL)
+            return -1;
+        if(heap_reserve((uint8_t*)block, need) != 0)
+            return -1;
+        block->span = (uint32_t)need;
+    }
+    chunk_use(block, size);
+    chunk_split(block);
+    return 0;
+}
+
+// Powiększenie kosztem wolnego poprzednika (i wolnego następnika); dane przesuwane na początek
+// poprzednika. NULL gdy poprzednik nie jest wolny albo razem nadal brakuje miejsca.
+static struct memory_chunk_t* chunk_resize_back(struct memory_chunk_t* block, size_t size)
+{
+    struct memory_chunk_t *prev = chunk_prev(block);
+    if(prev == NULL || !chunk_free(prev))
+        return NULL;
+
+    size_t need = chunk_need(size);
+    size_t span = chunk_span(prev) + chunk_span(block);
+    struct memory_chunk_t *next = chunk_next(block);
+    int next_free = next != NULL && chunk_free(next);
+    if(next_free)
+        span += chunk_span(next);
+    int last = block == manager->last_memory_chunk;
+    if(span < need){
+        // ostatni blok może jeszcze dobrać pamięć z końca sterty
+        if(!last || heap_reserve((uint8_t*)prev, need) != 0)
+            return NULL;
+        span = need;
+    }
+
+    bin_remove(prev);
+    if(next_free)
+        bin_remove(next);
+    if(last)
+        manager->last_memory_chunk = prev;
+    chunk_account(MAXIMA_USED, block, 0);
+    size_t old_size = block->size;
+    page_used_set((uint8_t*)block, (uint8_t*)block + chunk_need(old_size), NULL);
+    memmove((uint8_t*)prev + size_ch + FENCE, (uint8_t*)block + size_ch + FENCE, old_size);
+
+    chunk_set_span(prev, span);
+    struct memory_chunk_t *after = chunk_next(prev);
+    page_first_remove(block, after);
+    if(next_free)
+        page_first_remove(next, after);
+    chunk_use(prev, size);
+    chunk_split(prev);
+    return prev;
+}
+
+static int chunk_sum_ok(const struct memory_chunk_t* block)
+{
+    return block->sum_control == chunk_sum(block, manager->sum_key);
+}
+
+//
+// Slaby: strony z obiektami jednej klasy (do SLAB_MAX_SIZE) bez nagłówków i płotków przy obiektach.
+// Strony pochodzą z osobnej rezerwacji areny, więc o przynależności do slabu decyduje sam adres,
+// a nagłówek slabu leży na początku strony.
+struct slab_t
+{
+    uint64_t key;                   // sum_key ^ adres strony
+    struct slab_t* prev;            // lista slabów klasy z wolnymi miejscami
+    struct slab_t* next;
+    uint32_t size;                  // rozmiar obiektu, 0 - strona nieużywana
+    uint32_t count;                 // zajęte obiekty
+    uint64_t map[SLAB_MAP_WORDS];   // 1 - wolne miejsce
+};
+
+#define size_slab ((int)((sizeof(struct slab_t) + ALIGN - 1) & ~(size_t)(ALIGN - 1)))
+
+static uint8_t* slab_objects(const struct slab_t* slab)
+{
+    return (uint8_t*)slab + size_slab;
+}
+
+static uint32_t slab_capacity(size_t size)
+{
+    return (uint32_t)((PAGE - size_slab) / size);
+}
+
+// Slab, w którym leży wskaźnik; NULL poza rezerwacją slabów areny
+static struct slab_t* slab_of(struct memory_manager_t* arena, const void* pointer)
+{
+    const uint8_t *point = (const uint8_t*)pointer;
+    uint8_t *start = __atomic_load_n((uint8_t**)&arena->slab_start, __ATOMIC_ACQUIRE);
+    if(start == NULL || point < start || point >= start + __atomic_load_n(&arena->slab_top, __ATOMIC_ACQUIRE))
+        return NULL;
+    return (struct slab_t*)((uintptr_t)point & ~(uintptr_t)(PAGE - 1));
+}
+
+static int slab_key_ok(const struct slab_t* slab)
+{
+    return slab->key == (manager->sum_key ^ (uint64_t)(uintptr_t)slab);
+}
+
+static enum pointer_type_t slab_pointer_type(const struct slab_t* slab, const void* pointer)
+{
+    if(!slab_key_ok(slab))
+        return pointer_heap_corrupted;
+    size_t offset = (const uint8_t*)pointer - (const uint8_t*)slab;
+    if(offset < (size_t)size_slab)
+        return pointer_control_block;
+    if(slab->size == 0)
+        return pointer_unallocated;
+
+    size_t index = (offset - size_slab) / slab->size;
+    if(index >= slab_capacity(slab->size) || (slab->map[index >> 6] >> (index & 63)) & 1)
+        return pointer_unallocated;
+    if((offset - size_slab) % slab->size != 0)
+        return pointer_inside_data_block;
+    return pointer_valid;
+}
+
+static void slab_link(int index, struct slab_t* slab)
+{
+    slab->prev = NULL;
+    slab->next = manager->slabs[index];
+    if(slab->next)
+        slab->next->prev = slab;
+    manager->slabs[index] = slab;
+}
+
+static void slab_unlink(int index, struct slab_t* slab)
+{
+    if(slab->prev)
+        slab->prev->next = slab->next;
+    else
+        manager->slabs[index] = slab->next;
+    if(slab->next)
+        slab->next->prev = slab->prev;
+}
+
+// Pusta strona: najpierw z listy oddanych, potem kolejna z rezerwacji
+static struct slab_t* slab_page(void)
+{
+    struct slab_t *slab = manager->slab_empty;
+    if(slab != NULL){
+        manager->slab_empty = slab->next;
+        return slab;
+    }
+    if(manager->slab_start == NULL){
+        void *start = mmap(NULL, HEAP_SLAB_RESERVE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(start == MAP_FAILED)
+            return NULL;
+        __atomic_store_n(&manager->slab_start, start, __ATOMIC_RELEASE);
+    }
+    if(manager->slab_top + PAGE > HEAP_SLAB_RESERVE)
+        return NULL;
+    slab = (struct slab_t*)((uint8_t*)manager->slab_start + manager->slab_top);
+    slab->key = manager->sum_key ^ (uint64_t)(uintptr_t)slab;
+    slab->size = 0;
+    // slab_top czytane jest bez blokady w slab_of
+    __atomic_fetch_add(&manager->slab_top, PAGE, __ATOMIC_RELEASE);
+    return slab;
+}
+
+static void* slab_alloc(size_t size)
+{
+    size = align16(size);
+    int index = (int)(size / ALIGN) - 1;
+    uint32_t capacity = slab_capacity(size);
+    struct slab_t *slab = manager->slabs[index];
+    if(slab == NULL){
+        slab = slab_page();
+        if(slab == NULL)
+            return NULL;
+        slab->size = (uint32_t)size;
+        slab->count = 0;
+        for(uint32_t word = 0; word < SLAB_MAP_WORDS; word++){
+            uint32_t first = word * 64;
+            if(capacity >= first + 64)
+                slab->map[word] = ~(uint64_t)0;
+            else if(capacity > first)
+                slab->map[word] = ((uint64_t)1 << (capacity - first)) - 1;
+            else
+                slab->map[word] = 0;
+        }
+        slab_link(index, slab);
+    }
+
+    int word = 0;
+    while(slab->map[word] == 0)
+        word++;
+    int bit = __builtin_ctzll(slab->map[word]);
+    slab->map[word] &= slab->map[word] - 1;
+    manager->slab_bytes += size;
+    maxima_count(MAXIMA_USED, size, 1);
+    if(++slab->count == capacity)
+        slab_unlink(index, slab);
+    return slab_objects(slab) + ((size_t)word * 64 + (size_t)bit) * size;
+}
+
+static void slab_release(struct slab_t* slab, void* pointer)
+{
+    size_t size = slab->size;
+    uint8_t *point = (uint8_t*)pointer;
+    if(size == 0 || point < slab_objects(slab) || (size_t)(point - slab_objects(slab)) % size != 0)
+        return;
+    size_t position = (size_t)(point - slab_objects(slab)) / size;
+    uint32_t capacity = slab_capacity(size);
+    if(position >= capacity || (slab->map[position >> 6] >> (position & 63)) & 1)
+        return; // podwójne zwolnienie
+
+    int index = (int)(size / ALIGN) - 1;
+    slab->map[position >> 6] |= (uint64_t)1 << (position & 63);
+    manager->slab_bytes -= size;
+    maxima_count(MAXIMA_USED, size, 0);
+    if(slab->count-- == capacity)
+        slab_link(index, slab);
+    // pusta strona wraca do wspólnej puli, chyba że to jedyny slab klasy
+    if(slab->count == 0 && (slab->prev != NULL || slab->next != NULL)){
+        slab_unlink(index, slab);
+        slab->size = 0;
+        slab->next = manager->slab_empty;
+        manager->slab_empty = slab;
+    }
+}
+
+static int slab_validate(void)
+{
+    for(size_t offset = 0; offset < manager->slab_top; offset += PAGE){
+        struct slab_t *slab = (struct slab_t*)((uint8_t*)manager->slab_start + offset);
+        if(!slab_key_ok(slab) || (slab->size != 0 && slab->count > slab_capacity(slab->size)))
+            return 3;
+    }
+    return 0;
+}
+
+static size_t slab_largest_used(void)
+{
+    size_t size = 0;
+    for(size_t offset = 0; offset < manager->slab_top; offset += PAGE){
+        struct slab_t *slab = (struct slab_t*)((uint8_t*)manager->slab_start + offset);
+        if(slab->count > 0 && slab->size > size)
+            size = slab->size;
+    }
+    return size;
+}
+
+static void slab_unmap(struct memory_manager_t* arena)
+{
+    void *start = arena->slab_start;
+    if(start == NULL)
+        return;
+    __atomic_store_n(&arena->slab_start, NULL, __ATOMIC_RELEASE);
+    munmap(start, HEAP_SLAB_RESERVE);
+}
+
+// Sprawdzenie tylko bloku, na który wskazuje pointer - bez przeglądania całej sterty
+static enum pointer_type_t chunk_check(const void* pointer)
+{
+    if(pointer == NULL) return pointer_null;
+    if(manager->memory_start == NULL) return pointer_heap_corrupted;
+
+    struct slab_t *slab = slab_of(manager, pointer);
+    if(slab != NULL)
+        return slab_pointer_type(slab, pointer);
+
+    uint8_t *point = (uint8_t*)pointer;
+    if(point < (uint8_t*)manager->memory_start + size_ch + FENCE || point >= heap_tail())
+        return pointer_unallocated;
+
+    struct memory_chunk_t *block = (struct memory_chunk_t*)(point - size_ch - FENCE);
+    if(!chunk_sum_ok(block) || chunk_free(block))
+        return pointer_unallocated;
+    for(int i = 0; i < FENCE; i++)
+        if(point[-FENCE + i] != '#')
+            return pointer_heap_corrupted;
+    for(size_t i = 0; i < fence_after(block->size); i++)
+        if(point[block->size + i] != '#')
+            return pointer_heap_corrupted;
+    return pointer_valid;
+}
+
+// Kontrola wskaźnika zgodnie z poziomem integralności;
+// returned != 0 dla wskaźnika, który alokator właśnie zwraca
+static enum pointer_type_t check_pointer(const void* pointer, int returned)
+{
+    enum heap_integrity_t level = heap_options.integrity;
+    if(level == heap_integrity_sampled && ++sample_count >= heap_options.sample_period){
+        sample_count = 0;
+        level = heap_integrity_full;
+    }
+
+    if(level == heap_integrity_full)
+        return pointer_type(pointer);
+    if(pointer == NULL)
+        return pointer_null;
+    if(returned || level == heap_integrity_off)
+        return pointer_valid;
+    return chunk_check(pointer);
+}
+
+//
+// Przydział aren
+
+// Arena, do której należy wskaźnik; NULL gdy leży poza każdą z nich
+static struct arena_t* arena_of(const void* pointer)
+{
+    const uint8_t *point = (const uint8_t*)pointer;
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        struct memory_manager_t *arena = arenas[i].manager;
+        uint8_t *start = __atomic_load_n((uint8_t**)&arena->memory_start, __ATOMIC_ACQUIRE);
+        if(start != NULL && point >= start && point < start + __atomic_load_n(&arena->memory_size, __ATOMIC_ACQUIRE))
+            return &arenas[i];
+        if(slab_of(arena, pointer) != NULL)
+            return &arenas[i];
+    }
+    return NULL;
+}
+
+// Rezerwacja przestrzeni dla dodatkowej areny; wywołujący trzyma jej blokadę
+static int arena_create(struct memory_manager_t* arena)
+{
+    // bez heap_setup nie powstaje żadna arena
+    if(__atomic_load_n(&memory_manager.memory_start, __ATOMIC_ACQUIRE) == NULL)
+        return -1;
+    void *start = mmap(NULL, HEAP_ARENA_RESERVE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(start == MAP_FAILED)
+        return -1;
+    memset(arena, 0, sizeof(struct memory_manager_t));
+    arena->memory_reserved = HEAP_ARENA_RESERVE;
+    arena->memory_size = PAGE;
+    page_map_create(arena);
+    arena->sum_key = HEAP_SUM_SEED ^ (uint64_t)(uintptr_t)start;
+    __atomic_store_n(&arena->memory_start, start, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Zwolnienie dodatkowych aren; wywołujący trzyma blokadę areny 0
+static void arenas_release(void)
+{
+    for(int i = 1; i < HEAP_MAX_ARENAS; i++){
+        struct memory_manager_t *arena = arenas[i].manager;
+        pthread_mutex_lock(&arenas[i].lock);
+        if(arena->memory_start != NULL){
+            void *start = arena->memory_start;
+            __atomic_store_n(&arena->memory_start, NULL, __ATOMIC_RELEASE);
+            munmap(start, arena->memory_reserved);
+            slab_unmap(arena);
+            page_map_unmap(arena);
+            memset(arena, 0, sizeof(struct memory_manager_t));
+        }
+        __atomic_store_n(&arenas[i].remote_free, NULL, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&arenas[i].lock);
+    }
+}
+
+static void arena_enter(struct arena_t* arena)
+{
+    pthread_mutex_lock(&arena->lock);
+    manager = arena->manager;
+}
+
+static void arena_leave(struct arena_t* arena)
+{
+    pthread_mutex_unlock(&arena->lock);
+}
+
+static void block_release(void* memblock);
+
+// Zwolnienie bloków odłożonych przez inne wątki; wywołujący trzyma blokadę areny
+static void remote_drain(struct arena_t* arena)
+{
+    if(__atomic_load_n(&arena->remote_free, __ATOMIC_RELAXED) == NULL)
+        return;
+    struct tcache_entry_t *entry = __atomic_exchange_n(&arena->remote_free, NULL, __ATOMIC_ACQUIRE);
+    while(entry != NULL){
+        struct tcache_entry_t *next = entry->next;
+        entry->key = NULL;
+        block_release(entry);
+        entry = next;
+    }
+}
+
+// Zajęcie areny bieżącego wątku; wątki dostają areny po kolei
+static struct arena_t* arena_enter_thread(void)
+{
+    size_t count = heap_options.arena_count;
+    if(thread_arena < 0 || (size_t)thread_arena >= count)
+        thread_arena = (int)(__atomic_fetch_add(&arena_next, 1, __ATOMIC_RELAXED) % count);
+
+    struct arena_t *arena = &arenas[thread_arena];
+    arena_enter(arena);
+    if(thread_arena != 0 && manager->memory_start == NULL && arena_create(manager) != 0){
+        arena_leave(arena);
+        arena = &arenas[0];
+        arena_enter(arena);
+    }
+    remote_drain(arena);
+    return arena;
+}
+
+// Zajęcie areny, w której leży wskaźnik; obce wskaźniki sprawdza arena główna
+static struct arena_t* arena_enter_pointer(const void* pointer)
+{
+    struct arena_t *arena = arena_of(pointer);
+    if(arena == NULL)
+        arena = &arenas[0];
+    arena_enter(arena);
+    return arena;
+}
+
+static void tcache_flush(int index, uint32_t count);
+static void large_release_all(void);
+static void lifetime_reset(void);
+static void histogram_restart(void);
+
+int heap_set_option(enum heap_option_t option, size_t value)
+{
+    int status = 0;
+    int flush = 0;
+    arena_enter(&arenas[0]);
+    switch(option){
+        case heap_option_integrity:
+            if(value > heap_integrity_full)
+                status = -1;
+            else {
+                heap_options.integrity = (enum heap_integrity_t)value;
+                sample_count = 0;
+            }
+            break;
+        case heap_option_sample_period:
+            if(value == 0)
+                status = -1;
+            else
+                heap_options.sample_period = value;
+            break;
+        case heap_option_tcache:
+            if(value > UINT16_MAX)
+                status = -1;
+            else {
+                heap_options.tcache_count = value;
+                flush = 1;
+            }
+            break;
+        case heap_option_slab:
+            if(value > 1)
+                status = -1;
+            else
+                heap_options.slab = (int)value;
+            break;
+        case heap_option_engine:
+            if(value > heap_engine_tlsf)
+                status = -1;
+            else
+                heap_options.engine = (enum heap_engine_t)value;
+            break;
+        case heap_option_mmap_threshold:
+            heap_options.mmap_threshold = value;
+            break;
+        case heap_option_trim_threshold:
+            heap_options.trim_threshold = value;
+            break;
+        case heap_option_trim_pad:
+            heap_options.trim_pad = value;
+            break;
+        case heap_option_grow_min:
+            heap_options.grow_min = value;
+            break;
+        case heap_option_grow_max:
+            heap_options.grow_max = value;
+            break;
+        case heap_option_histogram:
+            // bez histogramu zwolnienia nie zdejmują próbek, więc stare adresy nie mogą przetrwać do ponownego włączenia
+            if(heap_options.histogram == 0 && value != 0)
+                lifetime_reset();
+            heap_options.histogram = value;
+            histogram_restart();
+            break;
+        case heap_option_arenas:
+            if(value == 0 || value > HEAP_MAX_ARENAS)
+                status = -1;
+            else
+                heap_options.arena_count = value;
+            break;
+        default:
+            status = -1;
+    }
+    arena_leave(&arenas[0]);
+
+    // nadmiar z pamięci podręcznej bieżącego wątku wraca do aren
+    if(flush && tcache.generation == __atomic_load_n(&heap_generation, __ATOMIC_ACQUIRE))
+        for(int i = 0; i < TCACHE_BINS; i++)
+            if(tcache.count[i] > value)
+                tcache_flush(i, tcache.count[i] - (uint32_t)value);
+    return status;
+}
+
+//
+// Liczniki operacji: każdy wątek zapisuje tylko własne, heap_get_stats sumuje je z listy wątków.
+// Liczniki kończącego się wątku trafiają do counters_retired, a heap_setup zapamiętuje sumę
+// jako punkt zerowy.
+struct heap_counters_t
+{
+    uint64_t mallocs;
+    uint64_t frees;
+    uint64_t reallocs;
+    uint64_t sizes[HEAP_BIN_COUNT];
+    uint64_t lifetimes[HEAP_LIFETIME_BUCKETS];
+    uint64_t sample_last;           // wartość mallocs przy poprzedniej próbce
+    uint64_t sample_epoch;          // histogram_epoch przy poprzedniej próbce
+    struct heap_counters_t* prev;
+    struct heap_counters_t* next;
+    int registered;
+};
+
+static _Thread_local struct heap_counters_t counters;
+static struct heap_counters_t* counters_list;
+static struct heap_counters_t counters_retired;
+static uint64_t histogram_epoch;                // zmieniany przy każdej zmianie opcji histogramu i w heap_setup
+static uint64_t histogram_mask = ~0ull;         // okres próbek - 1 (potęga dwójki); same jedynki gdy histogram wyłączony
+static struct heap_counters_t counters_base;
+static pthread_mutex_t counters_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t counters_key;
+static pthread_once_t counters_once = PTHREAD_ONCE_INIT;
+
+static void counters_fold(struct heap_counters_t* sum, struct heap_counters_t* thread)
+{
+    sum->mallocs += __atomic_load_n(&thread->mallocs, __ATOMIC_RELAXED);
+    sum->frees += __atomic_load_n(&thread->frees, __ATOMIC_RELAXED);
+    sum->reallocs += __atomic_load_n(&thread->reallocs, __ATOMIC_RELAXED);
+    for(int i = 0; i < HEAP_BIN_COUNT; i++)
+        sum->sizes[i] += __atomic_load_n(&thread->sizes[i], __ATOMIC_RELAXED);
+    for(int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+        sum->lifetimes[i] += __atomic_load_n(&thread->lifetimes[i], __ATOMIC_RELAXED);
+}
+
+static void counters_destroy(void* unused)
+{
+    (void)unused;
+    pthread_mutex_lock(&counters_lock);
+    counters_fold(&counters_retired, &counters);
+    if(counters.prev)
+        counters.prev->next = counters.next;
+    else
+        counters_list = counters.next;
+    if(counters.next)
+        counters.next->prev = counters.prev;
+    pthread_mutex_unlock(&counters_lock);
+    memset(&counters, 0, sizeof(counters));
+}
+
+static void counters_key_create(void)
+{
+    pthread_key_create(&counters_key, counters_destroy);
+}
+
+// Rejestracja przy pierwszym liczniku wątku - poza ścieżką przydziału, żeby counter_add pozostało krótkie
+__attribute__(( noinline, cold ))
+static void counters_register(void)
+{
+    pthread_once(&counters_once, counters_key_create);
+    pthread_setspecific(counters_key, &counters);
+    pthread_mutex_lock(&counters_lock);
+    counters.prev = NULL;
+    counters.next = counters_list;
+    if(counters_list)
+        counters_list->prev = &counters;
+    counters_list = &counters;
+    pthread_mutex_unlock(&counters_lock);
+    counters.registered = 1;
+}
+
+// Tylko wątek właściciel zmienia swoje liczniki, więc wystarczy zapis bez blokady
+static void counter_add(uint64_t* counter, uint64_t count)
+{
+    if(!counters.registered)
+        counters_register();
+    __atomic_store_n(counter, *counter + count, __ATOMIC_RELAXED);
+}
+
+// Suma liczników wszystkich wątków; wywołujący trzyma counters_lock
+static struct heap_counters_t counters_sum(void)
+{
+    struct heap_counters_t sum = counters_retired;
+    for(struct heap_counters_t *thread = counters_list; thread != NULL; thread = thread->next)
+        counters_fold(&sum, thread);
+    return sum;
+}
+
+//
+// Czasy życia: co histogram_mask + 1 przydział wątku trafia z chwilą przydziału do tablicy
+// adresów (bez przeszukiwania - zajęte miejsce oznacza pominiętą próbkę). Bajtowa mapa zajętych miejsc
+// mieści się w pamięci podręcznej L1, więc zwolnienie sprawdza jeden bajt i do tablicy zagląda tylko dla próbek.
+#define LIFETIME_SLOTS 4096
+#define LIFETIME_BUSY ((void*)1)
+
+static struct
+{
+    void *pointer;
+    uint64_t start;
+} lifetime_slots[LIFETIME_SLOTS];
+static uint8_t lifetime_map[LIFETIME_SLOTS];
+
+static uint64_t lifetime_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+_Static_assert(LIFETIME_SLOTS == 1 << 12, "miejsce to 12 górnych bitów skrótu");
+
+static size_t lifetime_slot(const void* pointer)
+{
+    return (size_t)((uintptr_t)pointer * 0x9E3779B97F4A7C15ull >> 52);
+}
+
+static void lifetime_put(void* pointer, uint64_t start)
+{
+    size_t slot = lifetime_slot(pointer);
+    void *empty = NULL;
+    if(!__atomic_compare_exchange_n(&lifetime_slots[slot].pointer, &empty, LIFETIME_BUSY, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return;
+    __atomic_store_n(&lifetime_slots[slot].start, start, __ATOMIC_RELAXED);
+    __atomic_store_n(&lifetime_slots[slot].pointer, pointer, __ATOMIC_RELEASE);
+    __atomic_store_n(&lifetime_map[slot], 1, __ATOMIC_RELEASE);
+}
+
+// 0 gdy miejsce wskaźnika w tablicy jest puste, więc wskaźnik na pewno nie jest próbką
+static int lifetime_marked(const void* pointer)
+{
+    return __atomic_load_n(&lifetime_map[lifetime_slot(pointer)], __ATOMIC_RELAXED);
+}
+
+// 1 gdy pointer był próbką; start to chwila jego przydziału.
+// Znacznik w mapie znika przed zwolnieniem miejsca, więc nie może skasować znacznika kolejnej próbki.
+static int lifetime_take(const void* pointer, uint64_t* start)
+{
+    if(!lifetime_marked(pointer))
+        return 0;
+    size_t slot = lifetime_slot(pointer);
+    void *expected = (void*)pointer;
+    if(!__atomic_compare_exchange_n(&lifetime_slots[slot].pointer, &expected, LIFETIME_BUSY, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+    *start = __atomic_load_n(&lifetime_slots[slot].start, __ATOMIC_RELAXED);
+    __atomic_store_n(&lifetime_map[slot], 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&lifetime_slots[slot].pointer, NULL, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void lifetime_reset(void)
+{
+    memset(lifetime_slots, 0, sizeof(lifetime_slots));
+    memset(lifetime_map, 0, sizeof(lifetime_map));
+}
+
+// Próbka rozmiaru liczy się za wszystkie przydziały wątku od poprzedniej, a blok trafia do tablicy czasów życia.
+// Po zmianie opcji (nowa epoka) liczą się tylko przydziały tego wywołania.
+__attribute__(( noinline, cold ))
+static void histogram_sample(void* memblock, size_t size, size_t count)
+{
+    uint64_t epoch = __atomic_load_n(&histogram_epoch, __ATOMIC_RELAXED);
+    if(counters.sample_epoch == epoch)
+        count = counters.mallocs - counters.sample_last;
+    counter_add(&counters.sizes[bin_index(size)], count);
+    counters.sample_epoch = epoch;
+    counters.sample_last = counters.mallocs;
+    lifetime_put(memblock, lifetime_now());
+}
+
+// Próbką jest przydział, z którym licznik mallocs wątku przekroczył wielokrotność okresu (reszta mniejsza
+// niż liczba bloków wywołania) - przy okresie 1 histogram jest dokładny. Przy wyłączonym histogramie maska
+// z samych jedynek zostawia cały licznik, więc przydział płaci to samo porównanie niezależnie od opcji.
+static void histogram_malloc(void* memblock, size_t size, size_t count)
+{
+    if(memblock != NULL && (counters.mallocs & __atomic_load_n(&histogram_mask, __ATOMIC_RELAXED)) < count)
+        histogram_sample(memblock, size, count);
+}
 
-int align_size(int size){
-    return (size + PAGE -1) & ~(PAGE -1);
+// Nowa epoka próbek z okresem z opcji zaokrąglonym w górę do potęgi dwójki
+static void histogram_restart(void)
+{
+    uint64_t mask = ~0ull;
+    if(heap_options.histogram != 0)
+        mask = heap_options.histogram == 1 ? 0 : (~0ull >> __builtin_clzll(heap_options.histogram - 1));
+    __atomic_store_n(&histogram_mask, mask, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram_epoch, 1, __ATOMIC_RELAXED);
+}
+
+// Czas życia próbki - rzadko, poza ścieżką zwolnienia
+__attribute__(( noinline, cold ))
+static void histogram_lifetime(const void* memblock)
+{
+    uint64_t start;
+    if(!lifetime_take(memblock, &start))
+        return;
+    uint64_t lifetime = lifetime_now() - start;
+    int bucket = lifetime == 0 ? 0 : 63 - __builtin_clzll(lifetime);
+    if(bucket >= HEAP_LIFETIME_BUCKETS)
+        bucket = HEAP_LIFETIME_BUCKETS - 1;
+    counter_add(&counters.lifetimes[bucket], 1);
+}
+
+// Zwolnienie sprawdza tylko bajt mapy; resztę robi histogram_lifetime dla bloków, które mogą być próbką
+static void histogram_free(const void* memblock)
+{
+    if(heap_options.histogram != 0 && memblock != NULL && lifetime_marked(memblock))
+        histogram_lifetime(memblock);
 }
 
 int heap_setup(void)
 {
-    memory_manager.memory_start = custom_sbrk(PAGE);
-    if(memory_manager.memory_start == (void *)-1) return -1;
-    memory_manager.first_memory_chunk = NULL;
+    pthread_mutex_lock(&counters_lock);
+    counters_base = counters_sum();
+    pthread_mutex_unlock(&counters_lock);
+    lifetime_reset();
+    histogram_restart();
+
+    arena_enter(&arenas[0]);
+    arenas_release();
+    large_release_all();
+    __atomic_store_n(&arenas[0].remote_free, NULL, __ATOMIC_RELAXED);
+    slab_unmap(&memory_manager);
+    page_map_unmap(&memory_manager);
+    memset(&memory_manager,0,sizeof(struct memory_manager_t));
+    __atomic_add_fetch(&heap_generation, 1, __ATOMIC_RELEASE);
+    heap_engine = heap_options.engine;
+    void *start = custom_sbrk(PAGE);
+    if(start == (void *)-1){
+        arena_leave(&arenas[0]);
+        return -1;
+    }
     memory_manager.memory_size = PAGE;
+    page_map_create(&memory_manager);
+#if defined(__x86_64__) && !defined(__SSE4_2__)
+    sum_crc_enabled = __builtin_cpu_supports("sse4.2");
+#endif
+    memory_manager.sum_key = HEAP_SUM_SEED ^ (uint64_t)(uintptr_t)start;
+    __atomic_store_n(&memory_manager.memory_start, start, __ATOMIC_RELEASE);
+    arena_leave(&arenas[0]);
     return 0;
 }
 
 void heap_clean(void)
 {
-    heap_validate();
+    arena_enter(&arenas[0]);
+    validate_heap();
+    arenas_release();
+    large_release_all();
     size_t heap_size = 0;
     void *ptr_sbrk = custom_sbrk(0);
     heap_size = (uint8_t*)ptr_sbrk - (uint8_t*)memory_manager.memory_start;
     custom_sbrk(-heap_size);
+    __atomic_store_n(&memory_manager.memory_start, NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&arenas[0].remote_free, NULL, __ATOMIC_RELAXED);
+    slab_unmap(&memory_manager);
+    page_map_unmap(&memory_manager);
     memset(&memory_manager,0,sizeof(struct memory_manager_t));
+    __atomic_add_fetch(&heap_generation, 1, __ATOMIC_RELEASE);
+    arena_leave(&arenas[0]);
+    lifetime_reset();
 }
 
-void* heap_malloc(size_t size)
+// 1 gdy któraś arena oddała pamięć systemowi
+int heap_trim(size_t pad)
+{
+    size_t released = 0;
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        arena_enter(&arenas[i]);
+        remote_drain(&arenas[i]);
+        released += heap_trim_locked(pad);
+        arena_leave(&arenas[i]);
+    }
+    return released != 0;
+}
+
+// Bloki z pamięci podręcznej wątku mają rozmiar zaokrąglony do klasy
+static size_t request_size(size_t size)
+{
+    if(heap_options.tcache_count > 0 && size <= TCACHE_MAX_SIZE)
+        return align16(size);
+    return size;
+}
+
+static struct memory_chunk_t* chunk_alloc(size_t size)
 {
-    if(size <= 0 ) return NULL;
+    struct memory_chunk_t *block = bin_find(size + 2*FENCE);
+    if(block != NULL){
+        bin_remove(block);
+        chunk_use(block, size);
+        chunk_split(block);
+        return block;
+    }
+    return chunk_append(heap_tail(), size);
+}
 
-    if (size + size_ch + 2*FENCE > memory_manager.memory_size) {
-        size_t siz_need = size + size_ch + 2*FENCE - memory_manager.memory_size;
-        siz_need = align_size(siz_need);
+static void chunk_release(struct memory_chunk_t* block)
+{
+    chunk_account(MAXIMA_USED, block, 0);
+    page_used_set((uint8_t*)block, (uint8_t*)block + chunk_need(block->size), NULL);
+    memset((uint8_t*)block + size_ch,'?', FENCE);
+    memset((uint8_t*)block + size_ch + FENCE + block->size,'?', fence_after(block->size));
+
+    // pojemność wolnego bloku nie obejmuje samego wyrównania za danymi
+    block->span |= CHUNK_FREE;
+    if(chunk_span(block) - chunk_need(block->size) == 0)
+        block->size += 2*FENCE;
+    else
+        block->size = (uint32_t)(chunk_span(block) - size_ch);
+    int last = block == manager->last_memory_chunk;
+
+    struct memory_chunk_t *next = chunk_next(block);
+    if(next != NULL && chunk_free(next)){ // 'Ccc'Fff
+        bin_remove(next);
+        block->size = (uint32_t)chunk_span(block) + next->size;
+        block->span += chunk_span(next);
+        page_first_remove(next, chunk_next(block));
+    }
+    struct memory_chunk_t *prev = chunk_prev(block);
+    if(prev != NULL && chunk_free(prev)){ // Fff'Ccc'
+        bin_remove(prev);
+        prev->size = (uint32_t)chunk_span(prev) + block->size;
+        prev->span += chunk_span(block);
+        page_first_remove(block, last ? NULL : chunk_next(prev));
+        block = prev;
+    }
 
-        void *ptr = custom_sbrk(siz_need);
-        if(ptr == (void*)-1)
-            return NULL;
-        memory_manager.memory_size += siz_need;
-    }
-
-    struct memory_chunk_t *first_block = memory_manager.first_memory_chunk;
-
-    if(first_block == NULL){
-        if(size + size_ch + 2*FENCE <= memory_manager.memory_size)
-        {
-            first_block = (struct memory_chunk_t *) memory_manager.memory_start;
-            memset((uint8_t*)memory_manager.memory_start + size_ch,'#', FENCE);
-            memset((uint8_t*)memory_manager.memory_start + size_ch + FENCE + size,'#', FENCE);
-            first_block->size = size;
-            first_block->free = 0;
-            first_block->next = NULL;
-            first_block->prev = NULL;
-            first_block->sum_control = 0;
-
-            first_block->sum_control = fun_sum_control(first_block);
-            memory_manager.memory_size += -size - size_ch - 2*FENCE;
-            memory_manager.first_memory_chunk = first_block;
+    if(last){ // Bbb'Ccc'... - ostatni blok wraca do końca sterty
+        page_first_remove(block, NULL);
+        prev = chunk_prev(block);
+        manager->last_memory_chunk = prev;
+        if(prev == NULL)
+            manager->first_memory_chunk = NULL;
+        // próg nie spada poniżej ostatniego przyrostu, żeby przydział i zwolnienie tego samego bloku
+        // nie przesuwały końca sterty za każdym razem
+        size_t threshold = heap_options.trim_threshold;
+        if(threshold != 0){
+            if(threshold < manager->memory_step)
+                threshold = manager->memory_step;
+            if((size_t)((uint8_t*)manager->memory_start + manager->memory_size - heap_tail()) >= threshold + heap_options.trim_pad)
+                heap_trim_locked(heap_options.trim_pad);
         }
+        return;
     }
-    else if(size + size_ch + 2*FENCE <= memory_manager.memory_size)
-    {
-        uint8_t *mem = (uint8_t*)memory_manager.memory_start;
-        size_t offset = 0;
-        struct memory_chunk_t* free_block = (struct memory_chunk_t*) memory_manager.memory_start;
-        while(free_block->free == 0 || free_block->free == 1){
-            if (free_block->free == 1 && free_block->size >= size +2*FENCE) break;
-            if(free_block->free == 0) {
-                offset += 2 * FENCE;
-                offset += unused_size((uint8_t*)free_block + size_ch +FENCE);
-            }
-            offset += free_block->size + size_ch;
-            if(free_block->next)
-                free_block = free_block->next;
-            else break;
-        }
+    chunk_set_span(block, chunk_span(block));
+    bin_insert(block);
+}
 
-        void *brk_0 = custom_sbrk(0);
-        if((uint8_t*)mem + offset + size_ch + 2*FENCE + size >= (uint8_t*)brk_0)
-            return NULL;
+// Rozmiar zajętego bloku odczytany bez blokady areny; 0 gdy wskaźnik nie wygląda na początek bloku.
+// Nagłówki areny mogą się właśnie zmieniać, więc czytany jest tylko rozmiar i płotki.
+static size_t block_size_unlocked(struct arena_t* arena, const void* memblock)
+{
+    const uint8_t *point = (const uint8_t*)memblock;
+    if(((uintptr_t)point & (ALIGN - 1)) != 0)
+        return 0;
+
+    struct slab_t *slab = slab_of(arena->manager, point);
+    if(slab != NULL){
+        size_t size = slab->size;
+        if(size == 0 || point < slab_objects(slab) || (size_t)(point - slab_objects(slab)) % size != 0)
+            return 0;
+        return size;
+    }
+
+    uint8_t *start = __atomic_load_n((uint8_t**)&arena->manager->memory_start, __ATOMIC_ACQUIRE);
+    if(start == NULL || point < start + size_ch + FENCE)
+        return 0;
+    size_t size = ((const struct memory_chunk_t*)(point - size_ch - FENCE))->size;
+    if(point + size + fence_after(size) > start + __atomic_load_n(&arena->manager->memory_size, __ATOMIC_ACQUIRE))
+        return 0;
+    if(heap_options.integrity != heap_integrity_off){
+        for(int i = 0; i < FENCE; i++)
+            if(point[-FENCE + i] != '#')
+                return 0;
+        for(size_t i = 0; i < fence_after(size); i++)
+            if(point[size + i] != '#')
+                return 0;
+    }
+    return size;
+}
+
+// Odłożenie bloku obcej areny o znanym rozmiarze na jej stos remote_free
+static int remote_push(struct arena_t* arena, void* memblock, size_t size)
+{
+    if(thread_arena < 0 || arena == &arenas[thread_arena] || size < sizeof(struct tcache_entry_t))
+        return -1;
+
+    struct tcache_entry_t *entry = (struct tcache_entry_t*)memblock;
+    if(entry->key == &remote_mark || entry->key == &tcache_mark)
+        return 0;
+
+    entry->key = &remote_mark;
+    entry->next = __atomic_load_n(&arena->remote_free, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&arena->remote_free, &entry->next, entry, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    typ_pointer = pointer_valid;
+    return 0;
+}
+
+// 0 gdy blok obcej areny trafił na jej stos remote_free - bez zajmowania blokady
+static int remote_put(void* memblock)
+{
+    if(thread_arena < 0 || memblock == NULL || heap_options.integrity == heap_integrity_full)
+        return -1;
+    struct arena_t *arena = arena_of(memblock);
+    if(arena == NULL || arena == &arenas[thread_arena])
+        return -1;
+    return remote_push(arena, memblock, block_size_unlocked(arena, memblock));
+}
+
+// Dane nowego bloku: małe rozmiary ze slabów, pozostałe z listy bloków
+static void* block_alloc(size_t size)
+{
+    if(heap_options.slab && size <= SLAB_MAX_SIZE){
+        void *memblock = slab_alloc(size);
+        if(memblock != NULL)
+            return memblock;
+    }
+    struct memory_chunk_t *block = chunk_alloc(size);
+    if(block == NULL)
+        return NULL;
+    return (uint8_t*)block + size_ch + FENCE;
+}
+
+static void block_release(void* memblock)
+{
+    struct slab_t *slab = slab_of(manager, memblock);
+    if(slab != NULL)
+        slab_release(slab, memblock);
+    else
+        chunk_release((struct memory_chunk_t*)((uint8_t*)memblock - size_ch - FENCE));
+}
+
+static void tcache_sync(void)
+{
+    uint64_t generation = __atomic_load_n(&heap_generation, __ATOMIC_ACQUIRE);
+    if(tcache.generation == generation)
+        return;
+    // sterta została wyczyszczona - zawartość pamięci podręcznej jest nieaktualna
+    memset(&tcache, 0, sizeof(tcache));
+    tcache.generation = generation;
+}
+
+// Zwolnienie count bloków z klasy index; każdy wraca do areny, z której pochodzi.
+// Bloki są najpierw rozdzielane według aren, żeby każdą zająć tylko raz.
+static void tcache_flush(int index, uint32_t count)
+{
+    struct tcache_entry_t *groups[HEAP_MAX_ARENAS] = { NULL };
+    while(count-- > 0 && tcache.bins[index] != NULL){
+        struct tcache_entry_t *entry = tcache.bins[index];
+        tcache.bins[index] = entry->next;
+        tcache.count[index]--;
+        entry->key = NULL;
+        if(remote_put(entry) == 0)
+            continue;
+        struct arena_t *arena = arena_of(entry);
+        int owner = arena != NULL ? (int)(arena - arenas) : 0;
+        entry->next = groups[owner];
+        groups[owner] = entry;
+    }
 
-        if (free_block->free == 0){
-            //struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)mem + offset); // tu zle offset
-            struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)free_block + size_ch + 2*FENCE + free_block->size);
-            brk_0 = custom_sbrk(0);
-            if(((uint8_t*)next_block + size_ch + 2*FENCE + size) >= (uint8_t*)brk_0)
-                return NULL;
-
-            memset((uint8_t*)next_block + size_ch,'#', FENCE);
-            memset((uint8_t*)next_block + size_ch + size + FENCE,'#', FENCE);
-            next_block->size = size;
-            next_block->free = 0;
-            next_block->next = NULL;
-            next_block->prev = free_block;
-            free_block->next = next_block;
-
-            next_block->sum_control = 0;
-            next_block->sum_control = fun_sum_control(next_block);
-            free_block->sum_control = 0;
-            free_block->sum_control = fun_sum_control(free_block);
-
-            memory_manager.memory_size += -size - size_ch - 2*FENCE;
-
-            typ_pointer = get_pointer_type((uint8_t*)next_block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)next_block + size_ch + FENCE;
-
-           return NULL;
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        if(groups[i] == NULL)
+            continue;
+        arena_enter(&arenas[i]);
+        while(groups[i] != NULL){
+            struct tcache_entry_t *entry = groups[i];
+            groups[i] = entry->next;
+            block_release(entry);
         }
+        arena_leave(&arenas[i]);
+    }
+}
 
-        if(free_block->free == 1){
-            memset((uint8_t*)free_block + size_ch,'#',FENCE);
-            memset((uint8_t*)free_block + size_ch + size + FENCE,'#',FENCE);
+static void tcache_destroy(void* unused)
+{
+    (void)unused;
+    if(tcache.generation == __atomic_load_n(&heap_generation, __ATOMIC_ACQUIRE))
+        for(int i = 0; i < TCACHE_BINS; i++)
+            tcache_flush(i, tcache.count[i]);
+    memset(&tcache, 0, sizeof(tcache));
+}
+
+static void tcache_key_create(void)
+{
+    pthread_key_create(&tcache_key, tcache_destroy);
+}
 
-            free_block->size = size;
-            free_block->free = 0;
-            free_block->sum_control = 0;
-            free_block->sum_control = fun_sum_control(free_block);
+// Rejestracja wątku, aby przy jego zakończeniu bloki wróciły na stertę
+static void tcache_register(void)
+{
+    if(tcache.registered)
+        return;
+    pthread_once(&tcache_once, tcache_key_create);
+    pthread_setspecific(tcache_key, &tcache);
+    tcache.registered = 1;
+}
 
-            memory_manager.memory_size += -size - 2*FENCE;
-            typ_pointer = get_pointer_type((uint8_t*)free_block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)free_block + size_ch + FENCE;
+static void* tcache_get(size_t size)
+{
+    if(size > TCACHE_MAX_SIZE)
+        return NULL;
+    tcache_sync();
+    int index = (int)(align16(size) / ALIGN) - 1;
+    uint32_t limit = (uint32_t)heap_options.tcache_count;
 
+    if(tcache.bins[index] == NULL){
+        if(limit == 0)
             return NULL;
+        // uzupełnienie połową limitu za jednym zajęciem blokady
+        struct arena_t *arena = arena_enter_thread();
+        for(uint32_t i = 0; i < (limit + 1) / 2 && manager->memory_start != NULL; i++){
+            struct tcache_entry_t *entry = block_alloc(align16(size));
+            if(entry == NULL)
+                break;
+            entry->next = tcache.bins[index];
+            entry->key = &tcache_mark;
+            tcache.bins[index] = entry;
+            tcache.count[index]++;
         }
+        arena_leave(arena);
+        if(tcache.bins[index] == NULL)
+            return NULL;
+        tcache_register();
     }
-    typ_pointer = get_pointer_type((uint8_t*)first_block + size_ch + FENCE);
-    if(typ_pointer == pointer_valid)
-        return (uint8_t*)first_block + size_ch + FENCE;
 
+    struct tcache_entry_t *entry = tcache.bins[index];
+    tcache.bins[index] = entry->next;
+    tcache.count[index]--;
+    entry->next = NULL;
+    entry->key = NULL;
+    return entry;
+}
+
+// Odłożenie bloku o znanym rozmiarze do pamięci podręcznej wątku
+static int tcache_push(void* memblock, size_t size)
+{
+    size_t limit = heap_options.tcache_count;
+    if(limit == 0 || size > TCACHE_MAX_SIZE || size != align16(size) || size < sizeof(struct tcache_entry_t))
+        return -1;
+    tcache_sync();
+
+    struct tcache_entry_t *entry = (struct tcache_entry_t*)memblock;
+    if(entry->key == &tcache_mark || entry->key == &remote_mark)
+        return 0;
+
+    int index = (int)(size / ALIGN) - 1;
+    tcache_register();
+    if(tcache.count[index] >= limit)
+        tcache_flush(index, (uint32_t)(limit + 1) / 2);
+    entry->next = tcache.bins[index];
+    entry->key = &tcache_mark;
+    tcache.bins[index] = entry;
+    tcache.count[index]++;
+    typ_pointer = pointer_valid;
+    return 0;
+}
+
+// 0 gdy blok trafił do pamięci podręcznej wątku
+static int tcache_put(void* memblock)
+{
+    if(memblock == NULL || heap_options.tcache_count == 0)
+        return -1;
+
+    struct arena_t *arena = arena_of(memblock);
+    if(arena == NULL)
+        return -1;
+    if(heap_options.integrity == heap_integrity_full){
+        arena_enter(arena);
+        enum pointer_type_t type = pointer_type(memblock);
+        arena_leave(arena);
+        if(type != pointer_valid)
+            return -1;
+    }
+
+    return tcache_push(memblock, block_size_unlocked(arena, memblock));
+}
+
+//
+// Duże bloki: każdy we własnym mapowaniu, poza listą bloków areny, oddawany systemowi od razu przy zwolnieniu.
+// Nagłówek i płotki jak w zwykłym bloku; mapowania łączy lista chroniona osobną blokadą.
+struct large_t
+{
+    uint64_t key;               // HEAP_SUM_SEED ^ adres ^ size ^ length
+    size_t size;
+    size_t length;              // rozmiar mapowania
+    struct large_t* prev;
+    struct large_t* next;
+};
+
+#define size_large ((int)((sizeof(struct large_t) + ALIGN - 1) & ~(size_t)(ALIGN - 1)))
+
+static pthread_mutex_t large_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct large_t* large_list;
+static size_t large_count;
+// sumy dla heap_get_stats, chronione przez large_lock
+static struct
+{
+    size_t bytes;
+    size_t fences;
+    size_t length;
+} large_total;
+
+static uint8_t* large_data(struct large_t* large)
+{
+    return (uint8_t*)large + size_large + FENCE;
+}
+
+static size_t large_length(size_t size)
+{
+    return align_size(size_large + FENCE + align16(size) + FENCE);
+}
+
+static uint64_t large_key(const struct large_t* large)
+{
+    return HEAP_SUM_SEED ^ (uint64_t)(uintptr_t)large ^ (uint64_t)large->size ^ ((uint64_t)large->length << 32);
+}
+
+static void large_use(struct large_t* large, size_t size)
+{
+    large->size = size;
+    large->key = large_key(large);
+    memset(large_data(large) - FENCE, '#', FENCE);
+    memset(large_data(large) + size, '#', fence_after(size));
+}
+
+// Mapowanie, w którym leży wskaźnik; wywołujący trzyma large_lock
+static struct large_t* large_find(const void* pointer)
+{
+    const uint8_t *point = (const uint8_t*)pointer;
+    for(struct large_t *large = large_list; large != NULL; large = large->next)
+        if(point >= (uint8_t*)large && point < (uint8_t*)large + large->length)
+            return large;
     return NULL;
 }
 
-void* heap_calloc(size_t number, size_t size)
+static enum pointer_type_t large_pointer_type(struct large_t* large, const void* pointer)
 {
-    if(number <= 0 || size <= 0) return NULL;
-    size_t size_b = number * size;
+    if(large->key != large_key(large))
+        return pointer_heap_corrupted;
+    const uint8_t *point = (const uint8_t*)pointer;
+    uint8_t *data = large_data(large);
+    if(point < data - FENCE)
+        return pointer_control_block;
+    if(point < data)
+        return pointer_inside_fences;
+    if(point == data)
+        return pointer_valid;
+    if(point < data + large->size)
+        return pointer_inside_data_block;
+    if(point < data + large->size + fence_after(large->size))
+        return pointer_inside_fences;
+    return pointer_unallocated;
+}
 
-    if (size_b + size_ch + 2*FENCE > memory_manager.memory_size) {
-        int siz_need = size_b + size_ch + 2*FENCE - memory_manager.memory_size;
-        siz_need = align_size(siz_need);
+static int large_validate_locked(void)
+{
+    for(struct large_t *large = large_list; large != NULL; large = large->next){
+        if(large->key != large_key(large))
+            return 3;
+        uint8_t *data = large_data(large);
+        for(int i = 0; i < FENCE; i++)
+            if(data[-FENCE + i] != '#')
+                return 1;
+        for(size_t i = 0; i < fence_after(large->size); i++)
+            if(data[large->size + i] != '#')
+                return 1;
+    }
+    return 0;
+}
 
-        void *ptr = custom_sbrk(siz_need);
-        if(ptr == (void*)-1)
-            return NULL;
-        memory_manager.memory_size += siz_need;
+// Wstawienie z zachowaniem porządku malejących rozmiarów - największy blok jest na początku listy
+static void large_link(struct large_t* large)
+{
+    struct large_t *prev = NULL, *next = large_list;
+    while(next != NULL && next->size > large->size){
+        prev = next;
+        next = next->next;
     }
+    large->prev = prev;
+    large->next = next;
+    if(prev)
+        prev->next = large;
+    else
+        large_list = large;
+    if(next)
+        next->prev = large;
+    large_total.bytes += large->size;
+    large_total.fences += FENCE + fence_after(large->size);
+    large_total.length += large->length;
+}
 
-    struct memory_chunk_t *first_block = memory_manager.first_memory_chunk;
+static void large_unlink(struct large_t* large)
+{
+    if(large->prev)
+        large->prev->next = large->next;
+    else
+        large_list = large->next;
+    if(large->next)
+        large->next->prev = large->prev;
+    large_total.bytes -= large->size;
+    large_total.fences -= FENCE + fence_after(large->size);
+    large_total.length -= large->length;
+}
 
-    if(first_block == NULL){
-        if(size_b + size_ch + 2*FENCE <= memory_manager.memory_size)
-        {
-            first_block = (struct memory_chunk_t *) memory_manager.memory_start;
-            memset((uint8_t*)memory_manager.memory_start + size_ch,'#', FENCE);
-            memset((uint8_t*)memory_manager.memory_start + size_ch + FENCE + size_b,'#', FENCE);
-            first_block->size = size_b;
-            first_block->free = 0;
-            first_block->next = NULL;
-            first_block->prev = NULL;
-            first_block->sum_control = 0;
+static void* large_alloc(size_t size)
+{
+    // bez heap_setup nie ma też dużych bloków
+    if(__atomic_load_n(&memory_manager.memory_start, __ATOMIC_ACQUIRE) == NULL)
+        return NULL;
+    size_t length = large_length(size);
+    struct large_t *large = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(large == MAP_FAILED)
+        return NULL;
+    large->length = length;
+    large_use(large, size);
+    block_zero = 1;
+
+    pthread_mutex_lock(&large_lock);
+    large_link(large);
+    __atomic_add_fetch(&large_count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&large_lock);
+    typ_pointer = pointer_valid;
+    return large_data(large);
+}
 
-            first_block->sum_control = fun_sum_control(first_block);
+// Duży blok wskazany przez wywołującego: nagłówek leży na początku strony przed danymi, bez klasyfikacji wskaźnika.
+// Mapowanie musi być na liście - po podwójnym zwolnieniu nagłówka już nie ma i nie wolno go czytać.
+// Niezgodny rozmiar zostawia blok i ustawia typ_pointer na pointer_heap_corrupted.
+static int large_free_direct(void* memblock, size_t size)
+{
+    struct large_t *large = (struct large_t*)((uint8_t*)memblock - FENCE - size_large);
+    if(((uintptr_t)large & (PAGE - 1)) != 0)
+        return -1;
+    pthread_mutex_lock(&large_lock);
+    if(large_find(memblock) != large || large->key != large_key(large)){
+        pthread_mutex_unlock(&large_lock);
+        return -1;
+    }
+    if(large->size != size){
+        pthread_mutex_unlock(&large_lock);
+        typ_pointer = pointer_heap_corrupted;
+        return 0;
+    }
+    large_unlink(large);
+    __atomic_sub_fetch(&large_count, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&large_lock);
+    munmap(large, large->length);
+    typ_pointer = pointer_valid;
+    return 0;
+}
 
-            memset((uint8_t*)first_block + size_ch + FENCE,0, size_b);
-            memory_manager.memory_size += -size_b - size_ch - 2*FENCE;
+// 0 gdy wskaźnik należał do dużego bloku (także nieprawidłowy - wtedy typ_pointer mówi dlaczego)
+static int large_free(void* memblock)
+{
+    if(__atomic_load_n(&large_count, __ATOMIC_RELAXED) == 0)
+        return -1;
+    pthread_mutex_lock(&large_lock);
+    struct large_t *large = large_find(memblock);
+    if(large == NULL){
+        pthread_mutex_unlock(&large_lock);
+        return -1;
+    }
+    typ_pointer = heap_options.integrity == heap_integrity_off ? pointer_valid : large_pointer_type(large, memblock);
+    if(typ_pointer == pointer_valid){
+        large_unlink(large);
+        __atomic_sub_fetch(&large_count, 1, __ATOMIC_RELAXED);
+        munmap(large, large->length);
+    }
+    pthread_mutex_unlock(&large_lock);
+    return 0;
+}
 
-            memory_manager.first_memory_chunk = first_block;
-        }
+// Zmiana rozmiaru dużego bloku, w razie potrzeby z przeniesieniem mapowania przez mremap.
+// -1 gdy wskaźnik nie należy do dużego bloku.
+static int large_realloc(void* memblock, size_t size, void** result)
+{
+    if(__atomic_load_n(&large_count, __ATOMIC_RELAXED) == 0)
+        return -1;
+    pthread_mutex_lock(&large_lock);
+    struct large_t *large = large_find(memblock);
+    if(large == NULL){
+        pthread_mutex_unlock(&large_lock);
+        return -1;
     }
-    else if(size_b + size_ch + 2*FENCE <= memory_manager.memory_size)
-    {
-        uint8_t *mem = memory_manager.memory_start;
-        int offset = 0;
-        struct memory_chunk_t* free_block = (struct memory_chunk_t*) memory_manager.memory_start;
-        while(free_block->free == 0 || free_block->free == 1){
-            if (free_block->free == 1 && free_block->size >= size_b +2*FENCE) break;
-            if(free_block->free == 0) {
-                offset += 2 * FENCE;
-                offset += unused_size((uint8_t*)free_block + size_ch +FENCE);
+    *result = NULL;
+    typ_pointer = heap_options.integrity == heap_integrity_off ? pointer_valid : large_pointer_type(large, memblock);
+    if(typ_pointer == pointer_valid){
+        size_t length = large_length(size);
+        large_unlink(large);
+        if(length != large->length){
+            struct large_t *moved = mremap(large, large->length, length, MREMAP_MAYMOVE);
+            if(moved == MAP_FAILED){
+                large_link(large);
+                pthread_mutex_unlock(&large_lock);
+                return 0;
             }
-            offset += free_block->size + size_ch;
-            if(free_block->next)
-                free_block = free_block->next;
-            else break;
+            large = moved;
+            large->length = length;
         }
+        large_use(large, size);
+        large_link(large);
+        *result = large_data(large);
+    }
+    pthread_mutex_unlock(&large_lock);
+    return 0;
+}
 
-        void *brk_0 = custom_sbrk(0);
-        if((uint8_t*)mem + offset + size_ch + 2*FENCE + size_b >= (uint8_t*)brk_0)
-            return NULL;
+// Rozmiar prawidłowego dużego bloku; 0 dla pozostałych wskaźników
+static size_t large_size(const void* memblock)
+{
+    if(__atomic_load_n(&large_count, __ATOMIC_RELAXED) == 0)
+        return 0;
+    pthread_mutex_lock(&large_lock);
+    struct large_t *large = large_find(memblock);
+    size_t size = large != NULL && large_pointer_type(large, memblock) == pointer_valid ? large->size : 0;
+    pthread_mutex_unlock(&large_lock);
+    return size;
+}
 
-        if (free_block->free == 0){
-            //struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)mem + offset);
-            struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)free_block + size_ch + 2*FENCE + free_block->size);
-            brk_0 = custom_sbrk(0);
-            if(((uint8_t*)next_block + size_ch + 2*FENCE + size_b) >= (uint8_t*)brk_0)
-                return NULL;
-
-            memset((uint8_t*)next_block + size_ch,'#', FENCE);
-            memset((uint8_t*)next_block + size_ch + size_b + FENCE,'#', FENCE);
-            next_block->size = size_b;
-            next_block->free = 0;
-            next_block->next = NULL;
-            next_block->prev = free_block;
-            free_block->next = next_block;
-
-            next_block->sum_control = 0;
-            next_block->sum_control = fun_sum_control(next_block);
-            free_block->sum_control = 0;
-            free_block->sum_control = fun_sum_control(free_block);
-
-            memset((uint8_t*)next_block + size_ch + FENCE,0, size_b);
-
-            memory_manager.memory_size += -size_b - size_ch - 2*FENCE;
-
-            typ_pointer = get_pointer_type((uint8_t*)next_block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)next_block + size_ch + FENCE;
-            return NULL;
-        }
+static void large_release_all(void)
+{
+    pthread_mutex_lock(&large_lock);
+    while(large_list != NULL){
+        struct large_t *large = large_list;
+        large_list = large->next;
+        munmap(large, large->length);
+    }
+    memset(&large_total, 0, sizeof(large_total));
+    __atomic_store_n(&large_count, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&large_lock);
+}
 
-        if(free_block->free == 1){
-            memset((uint8_t*)free_block + size_ch,'#',FENCE);
-            memset((uint8_t*)free_block + size_ch + size_b + FENCE,'#',FENCE);
+static void* malloc_locked(size_t size)
+{
+    if(manager->memory_start == NULL) return NULL;
 
-            free_block->size = size_b;
-            free_block->free = 0;
-            free_block->sum_control = 0;
+    void *memblock = block_alloc(request_size(size));
+    if(memblock == NULL)
+        return NULL;
 
-            free_block->sum_control = fun_sum_control(free_block);
+    typ_pointer = check_pointer(memblock, 1);
+    if(typ_pointer == pointer_valid)
+        return memblock;
 
-            memset((uint8_t*)free_block + size_ch + FENCE,0, size_b);
+    return NULL;
+}
 
-            memory_manager.memory_size += -size_b - 2*FENCE;
+// Zwolnienie bloku, który przeszedł już kontrolę wskaźnika
+static void free_checked(void* memblock)
+{
+    struct slab_t *slab = slab_of(manager, memblock);
+    struct memory_chunk_t *block = (struct memory_chunk_t*) ((uint8_t*)memblock - size_ch - FENCE);
+    if(slab == NULL && chunk_free(block)) return;
+    if(slab != NULL || block->size >= sizeof(struct tcache_entry_t)){
+        const void *key = ((struct tcache_entry_t*)memblock)->key;
+        if(key == &tcache_mark || key == &remote_mark)
+            return; // blok leży w pamięci podręcznej wątku albo czeka na stosie remote_free
+    }
+    block_release(memblock);
+}
 
-            typ_pointer = get_pointer_type((uint8_t*)free_block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)free_block + size_ch + FENCE;
-            return NULL;
+static void free_locked(void* memblock)
+{
+    typ_pointer = check_pointer(memblock, 0);
+    if(typ_pointer != pointer_valid)
+        return;
+    free_checked(memblock);
+}
+
+// Przydział count bloków jednego rozmiaru; liczba przydzielonych bloków
+static size_t malloc_batch_locked(size_t size, size_t count, void** out)
+{
+    if(manager->memory_start == NULL || count == 0) return 0;
+
+    size = request_size(size);
+    size_t done = 0;
+    if(heap_options.slab && size <= SLAB_MAX_SIZE)
+        while(done < count && (out[done] = slab_alloc(size)) != NULL)
+            done++;
+
+    // jeden ciągły obszar na wszystkie bloki: wolny blok z koszyka albo koniec sterty
+    size_t need = chunk_need(size);
+    size_t rest = count - done;
+    struct memory_chunk_t *block = NULL;
+    if(rest != 0 && rest <= CHUNK_MAX_SPAN / need)
+        block = bin_find(need * rest - size_ch);
+    if(block != NULL){
+        bin_remove(block);
+        for(;;){
+            chunk_use(block, size);
+            chunk_split(block);
+            out[done++] = (uint8_t*)block + size_ch + FENCE;
+            // kolejny blok to wolna reszta za właśnie przydzielonym
+            block = chunk_next(block);
+            if(done == count || block == NULL || !chunk_free(block))
+                break;
+            bin_remove(block);
+        }
+    }
+    else if(rest != 0 && rest <= CHUNK_MAX_SPAN / need && heap_reserve(heap_tail(), need * rest) == 0){
+        while(done < count && (block = chunk_append(heap_tail(), size)) != NULL)
+            out[done++] = (uint8_t*)block + size_ch + FENCE;
+    }
+    while(done < count && (block = chunk_alloc(size)) != NULL)
+        out[done++] = (uint8_t*)block + size_ch + FENCE;
+
+    // jedna kontrola na całą serię; po błędzie wycięte już bloki wracają do sterty
+    if(done != 0){
+        typ_pointer = check_pointer(out[0], 1);
+        if(typ_pointer != pointer_valid){
+            while(done > 0)
+                block_release(out[--done]);
+            return 0;
         }
     }
-    typ_pointer = get_pointer_type((uint8_t*)first_block + size_ch + FENCE);
+    return done;
+}
+
+static void* memalign_locked(size_t alignment, size_t size);
+
+// alignment 0 to zwykłe przydzielenie
+static void* arena_malloc_locked(size_t alignment, size_t size)
+{
+    if(alignment == 0)
+        return malloc_locked(size);
+    return memalign_locked(alignment, size);
+}
+
+static void* arena_malloc(size_t alignment, size_t size)
+{
+    struct arena_t *arena = arena_enter_thread();
+    void *memblock = arena_malloc_locked(alignment, size);
+    arena_leave(arena);
+    if(memblock == NULL && arena != &arenas[0]){
+        arena_enter(&arenas[0]);
+        memblock = arena_malloc_locked(alignment, size);
+        arena_leave(&arenas[0]);
+    }
+    return memblock;
+}
+
+// Zmiana rozmiaru w miejscu; 0 gdy się udało (blok w *result), -1 gdy blok trzeba przenieść, -2 przy błędzie
+static int realloc_locked(void* memblock, size_t size, size_t alignment, size_t* old_size, void** result)
+{
+    *result = memblock;
+    if(manager->memory_start == NULL) return -2;
+
+    typ_pointer = check_pointer(memblock, 0);
+    if(typ_pointer != pointer_valid)
+        return -2;
+
+    // obiekt slabu mieści się w miejscu tylko w obrębie swojej klasy
+    struct slab_t *slab = slab_of(manager, memblock);
+    if(slab != NULL){
+        *old_size = slab->size;
+        return alignment == 0 && size <= slab->size ? 0 : -1;
+    }
+
+    struct memory_chunk_t *block = (struct memory_chunk_t *) ((uint8_t *)memblock - FENCE - size_ch);
+    *old_size = block->size;
+    if(alignment != 0 && ((uintptr_t)memblock & (alignment - 1)) != 0)
+        return -1;
+    if(chunk_resize(block, request_size(size)) != 0){
+        // wyrównany blok nie może się przesunąć w tył
+        if(alignment != 0 || (block = chunk_resize_back(block, request_size(size))) == NULL)
+            return -1;
+        memblock = *result = (uint8_t*)block + size_ch + FENCE;
+    }
+
+    typ_pointer = check_pointer(memblock, 1);
     if(typ_pointer == pointer_valid)
-        return (uint8_t*)first_block + size_ch + FENCE;
-    return NULL;
+        return 0;
+    return -2;
+}
+
+static void free_block(void* memblock);
+
+// heap_malloc bez liczników - także dla przeniesienia w heap_realloc
+static void* malloc_block(size_t size)
+{
+    if(size <= 0 || size >= CHUNK_MAX_SPAN) return NULL;
+    if(heap_options.mmap_threshold != 0 && size >= heap_options.mmap_threshold)
+        return large_alloc(size);
+
+    void *memblock = tcache_get(size);
+    if(memblock != NULL){
+        typ_pointer = pointer_valid;
+        return memblock;
+    }
+
+    return arena_malloc(0, size);
+}
+
+void* heap_malloc(size_t size)
+{
+    void *memblock = malloc_block(size);
+    if(memblock != NULL)
+        counter_add(&counters.mallocs, 1);
+    histogram_malloc(memblock, size, 1);
+    return memblock;
+}
+
+// Zmiana rozmiaru liczona w histogramie dokładnie - jest rzadsza i droższa niż przydział;
+// przeniesiony blok zachowuje chwilę przydziału próbki
+static void* histogram_realloc(void* memblock, void* new_memblock, size_t size)
+{
+    if(heap_options.histogram == 0 || new_memblock == NULL)
+        return new_memblock;
+    counter_add(&counters.sizes[bin_index(size)], 1);
+    uint64_t start;
+    if(new_memblock != memblock && lifetime_take(memblock, &start))
+        lifetime_put(new_memblock, start);
+    return new_memblock;
+}
+
+// Zerowanie dużych bloków zapisem nieczasowym, żeby nie wypychać z pamięci podręcznej danych programu
+static void zero_fill(void* memblock, size_t size)
+{
+#if defined(__SSE2__)
+    if(size >= HEAP_STREAM_THRESHOLD && ((uintptr_t)memblock & 15) == 0){
+        __m128i zero = _mm_setzero_si128();
+        __m128i *point = (__m128i*)memblock;
+        size_t count = size / sizeof(__m128i);
+        for(size_t i = 0; i < count; i++)
+            _mm_stream_si128(point + i, zero);
+        _mm_sfence();
+        memset(point + count, 0, size - count * sizeof(__m128i));
+        return;
+    }
+#endif
+    memset(memblock, 0, size);
+}
+
+void* heap_calloc(size_t number, size_t size)
+{
+    if(number <= 0 || size <= 0) return NULL;
+    if(number > SIZE_MAX / size) return NULL;
+    size_t size_b = number * size;
+
+    block_zero = 0;
+    void *memblock = heap_malloc(size_b);
+    if(memblock == NULL)
+        return NULL;
+    if(!block_zero)
+        zero_fill(memblock, size_b);
+    return memblock;
+}
+
+void* heap_realloc(void* memblock, size_t size)
+{
+    if(size == 0){
+        heap_free(memblock);
+        return NULL;
+    }
+    if(size >= CHUNK_MAX_SPAN) return NULL;
+    if(memblock == NULL)
+        return heap_malloc(size);
+    counter_add(&counters.reallocs, 1);
+
+    void *large_memblock = NULL;
+    if(arena_of(memblock) == NULL && large_realloc(memblock, size, &large_memblock) == 0)
+        return histogram_realloc(memblock, large_memblock, size);
+
+    size_t old_size = 0;
+    void *new_memblock = NULL;
+    struct arena_t *arena = arena_enter_pointer(memblock);
+    int status = realloc_locked(memblock, size, 0, &old_size, &new_memblock);
+    arena_leave(arena);
+    if(status == 0)
+        return histogram_realloc(memblock, new_memblock, size);
+    if(status == -2)
+        return NULL;
+
+    // przeniesienie: wolny blok z koszyków, a w ostateczności koniec sterty
+    new_memblock = malloc_block(size);
+    if(new_memblock == NULL)
+        return NULL;
+    memcpy(new_memblock, memblock, old_size < size ? old_size : size);
+    histogram_realloc(memblock, new_memblock, size);
+    free_block(memblock);
+    return new_memblock;
+}
+
+static void free_block(void* memblock)
+{
+    if(tcache_put(memblock) == 0 || remote_put(memblock) == 0)
+        return;
+    if(arena_of(memblock) == NULL && large_free(memblock) == 0)
+        return;
+
+    struct arena_t *arena = arena_enter_pointer(memblock);
+    free_locked(memblock);
+    arena_leave(arena);
+}
+
+void heap_free(void* memblock)
+{
+    if(memblock != NULL)
+        counter_add(&counters.frees, 1);
+    histogram_free(memblock);
+    free_block(memblock);
+}
+
+// Rozmiar podany do heap_free_sized wobec zapisanego w bloku - blok mógł zostać zaokrąglony do klasy rozmiaru
+static int free_size_match(size_t size, size_t stored, int slab)
+{
+    return size <= stored && (slab || stored <= align16(size));
+}
+
+// Rozmiar podany do heap_free_sized zgadza się z nagłówkiem bloku - z klasyfikacją wskaźnika pod blokadą
+static int free_size_ok(struct arena_t* arena, void* memblock, size_t size)
+{
+    if(arena == NULL){
+        pthread_mutex_lock(&large_lock);
+        struct large_t *large = large_find(memblock);
+        int ok = large != NULL && large->size == size;
+        pthread_mutex_unlock(&large_lock);
+        return ok;
+    }
+
+    arena_enter(arena);
+    int ok = check_pointer(memblock, 0) == pointer_valid;
+    if(ok){
+        struct slab_t *slab = slab_of(manager, memblock);
+        size_t stored = slab != NULL ? slab->size : ((struct memory_chunk_t*)((uint8_t*)memblock - size_ch - FENCE))->size;
+        ok = free_size_match(size, stored, slab != NULL);
+    }
+    arena_leave(arena);
+    return ok;
 }
 
-void* heap_realloc(void* memblock, size_t size)
+void heap_free_sized(void* memblock, size_t size)
 {
-    if(memory_manager.memory_start == NULL) return NULL;
-    if(size == 0){
-        heap_free(memblock);
-        return NULL;
+    if(memblock == NULL) return;
+    counter_add(&counters.frees, 1);
+    histogram_free(memblock);
+
+    // niezgodny rozmiar zostawia blok przydzielony - w każdej wersji, bo szybka ścieżka i tak czyta nagłówek
+    struct arena_t *arena = arena_of(memblock);
+    if(heap_options.integrity == heap_integrity_full){
+        if(!free_size_ok(arena, memblock, size)){
+            typ_pointer = pointer_heap_corrupted;
+            return;
+        }
+        free_block(memblock);
+        return;
     }
 
-    typ_pointer = get_pointer_type(memblock);
-    if(typ_pointer == pointer_valid || typ_pointer == pointer_null)
-    {
-        if (memblock == NULL) {
-            void *m = heap_malloc(size);
-            return (uint8_t *) m;
-        }
-        struct memory_chunk_t *block_realloc = (struct memory_chunk_t *) ((uint8_t *)memblock - FENCE - size_ch);
-        if (size == block_realloc->size) return (uint8_t *) memblock;
-        if (size < block_realloc->size) {
-            memory_manager.memory_size += block_realloc->size - size;
-
-            memset((uint8_t*)block_realloc + size_ch + FENCE + block_realloc->size,'r', FENCE);
-            block_realloc->size = size;
-            memset((uint8_t*)block_realloc + size_ch + FENCE + size,'#', FENCE);
-            block_realloc->sum_control = 0;
-            block_realloc->sum_control = fun_sum_control(block_realloc);
-            typ_pointer = get_pointer_type(memblock);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)memblock;
-        }
-        size_t size_2 = 0;
-        if (size > block_realloc->size)
-        {
-            int unused_1 = unused_size(memblock);
-            unsigned int to_sbrk = 0;
-            void *p_brk = custom_sbrk(0);
-            uint8_t *p_block_r = (uint8_t*)block_realloc;
-
-            if(block_realloc->next == NULL && (uint8_t*)p_block_r + size_ch + block_realloc->size + 2*FENCE < (uint8_t*)p_brk) {
-                while ((uint8_t *) p_block_r + size_ch + block_realloc->size + 2 * FENCE != (uint8_t *) p_brk) {
-                    to_sbrk++;
-                    p_block_r++;
-                }
-            }
+    if(arena == NULL){
+        if(large_free_direct(memblock, size) != 0 && large_free(memblock) != 0)
+            typ_pointer = pointer_unallocated;
+        return;
+    }
 
-             if((block_realloc->next) && (block_realloc->next->free == 1) && (block_realloc->size + block_realloc->next->size + unused_1 + size_ch) >= size) { // AaaaaB.... po AaaaaaaaB
-                memory_manager.memory_size += size_ch;
-                size_2 = size - block_realloc->size;
-                memset((uint8_t*)block_realloc + size_ch + FENCE + block_realloc->size,'r', FENCE);
-                block_realloc->size = size;
-                block_realloc->next->next->prev = block_realloc;
-                block_realloc->next = block_realloc->next->next;
-
-                memset((uint8_t*)block_realloc + size_ch + FENCE + block_realloc->size,'#', FENCE);
-                block_realloc->sum_control = 0;
-                block_realloc->sum_control = fun_sum_control(block_realloc);
-
-                block_realloc->next->sum_control = 0;
-                block_realloc->next->sum_control = fun_sum_control(block_realloc->next);
-                memory_manager.memory_size += -size_2;
-
-                typ_pointer = get_pointer_type((uint8_t*)block_realloc + size_ch + FENCE);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)block_realloc + size_ch + FENCE;
-            }
+    // rozmiar klasy wprost z nagłówka, bez klasyfikacji wskaźnika i sprawdzania płotków
+    struct slab_t *slab = slab_of(arena->manager, memblock);
+    size_t stored = slab != NULL ? slab->size : ((struct memory_chunk_t*)((uint8_t*)memblock - size_ch - FENCE))->size;
+    if(!free_size_match(size, stored, slab != NULL)){
+        typ_pointer = pointer_heap_corrupted;
+        return;
+    }
+    if(tcache_push(memblock, stored) == 0 || remote_push(arena, memblock, stored) == 0)
+        return;
 
-            if(block_realloc->next == NULL && block_realloc->size + to_sbrk >= size){
-                void *brk_0 = custom_sbrk(0);
-                if((uint8_t*)block_realloc + size_ch + 2*FENCE + size >= (uint8_t*)brk_0)
-                    return NULL;
-                memset((uint8_t*)block_realloc + size_ch + FENCE + block_realloc->size,'r', FENCE);
-                size_2 = size - block_realloc->size;
-                block_realloc->size = size;
-                memset((uint8_t*)block_realloc + size_ch + size + FENCE,'#',FENCE);
-
-                block_realloc->sum_control = 0;
-                block_realloc->sum_control = fun_sum_control(block_realloc);
-                memory_manager.memory_size += -size_2;
-
-                typ_pointer = get_pointer_type(memblock);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)memblock;
-            }
+    arena_enter(arena);
+    free_checked(memblock);
+    typ_pointer = pointer_valid;
+    arena_leave(arena);
+}
 
-            if(block_realloc->next == NULL && block_realloc->size + to_sbrk < size){
-                size_2 = size - block_realloc->size;
-                size_t siz_need = size - block_realloc->size - to_sbrk;
-                siz_need = align_size(siz_need);
-                void *ptr = custom_sbrk(siz_need);
-                if (ptr == (void *) -1)
-                    return NULL;
-                memory_manager.memory_size += siz_need;
-                void *brk_0 = custom_sbrk(0);
-                if((uint8_t*)block_realloc + size_ch + 2*FENCE + size >= (uint8_t*)brk_0)
-                    return NULL;
-
-                memset((uint8_t*)block_realloc + size_ch + FENCE + block_realloc->size,'r', FENCE);
-                block_realloc->size = size;
-
-                memset((uint8_t*)block_realloc + size_ch + size + FENCE,'#',FENCE);
-
-                block_realloc->sum_control = 0;
-                block_realloc->sum_control = fun_sum_control(block_realloc);
-                memory_manager.memory_size += -size_2;
-
-                typ_pointer = get_pointer_type(memblock);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)memblock;
-            }
+size_t heap_malloc_batch(size_t size, size_t count, void** out)
+{
+    if(size <= 0 || size >= CHUNK_MAX_SPAN || out == NULL) return 0;
 
-            if(block_realloc->next) {
-                struct memory_chunk_t *free_block = (struct memory_chunk_t *) ((uint8_t *)memory_manager.memory_start);
-                while (free_block) {
-                    if ((free_block->free == 1) && (free_block->size >= size + 2*FENCE)) {
-                        size_2 = free_block->size;
-                        free_block->size = size;
-                        free_block->free = 0;
-
-                        free_block->sum_control = 0;
-                        free_block->sum_control = fun_sum_control(free_block);
-
-                        memcpy((uint8_t*)free_block + size_ch, (uint8_t*)block_realloc + size_ch,block_realloc->size + FENCE);
-                        memset((uint8_t*)free_block + size_ch + size + FENCE, '#', FENCE);
-                        heap_free((uint8_t*)block_realloc + size_ch + FENCE);
-
-                        memory_manager.memory_size += -size -2*FENCE;
-                        typ_pointer = get_pointer_type((uint8_t *) free_block + size_ch + FENCE);
-                        if (typ_pointer == pointer_valid)
-                            return (uint8_t *) free_block + size_ch + FENCE;
-                    }
-                    free_block = free_block->next;
-                }
-
-                size_t siz_need = size + 2*FENCE + size_ch;
-                siz_need = align_size(siz_need);
-                void *ptr = custom_sbrk(siz_need);
-                if (ptr == (void *) -1)
-                    return NULL;
-                memory_manager.memory_size += siz_need;
-                struct memory_chunk_t *wsk = block_realloc;
-
-                while (wsk && wsk->next) {
-                    wsk = wsk->next;
-                }
-
-                int unused_wsk = unused_size((uint8_t*)wsk+size_ch+FENCE);
-                void *brk_0 = custom_sbrk(0);
-                if((uint8_t*)wsk + 2*size_ch + 4*FENCE + wsk->size + unused_wsk + size >= (uint8_t*)brk_0)
-                    return NULL;
-
-                struct memory_chunk_t *new_block_r = (struct memory_chunk_t *) ((uint8_t *) wsk +
-                                                                                size_ch +
-                                                                                wsk->size + 2*FENCE + unused_wsk);
-                memcpy((uint8_t *) new_block_r + size_ch,
-                       (uint8_t *) block_realloc + size_ch, FENCE + block_realloc->size);
-                new_block_r->size = size;
-                new_block_r->free = 0;
-                new_block_r->next = NULL;
-                new_block_r->prev = wsk;
-                wsk->next = new_block_r;
-
-                new_block_r->sum_control = 0;
-                new_block_r->sum_control = fun_sum_control(new_block_r);
-                wsk->sum_control = 0;
-                wsk->sum_control = fun_sum_control(wsk);
-                memset((uint8_t *) new_block_r + size_ch + new_block_r->size + FENCE, '#', FENCE);
-
-                heap_free((uint8_t*)block_realloc + size_ch + FENCE);
-
-                memory_manager.memory_size += -size - size_ch - 2*FENCE;
-                typ_pointer = get_pointer_type((uint8_t *) new_block_r + size_ch + FENCE);
-                if (typ_pointer == pointer_valid)
-                    return (uint8_t *) new_block_r + size_ch + FENCE;
-            }
+    size_t done = 0;
+    if(heap_options.mmap_threshold != 0 && size >= heap_options.mmap_threshold){
+        while(done < count && (out[done] = large_alloc(size)) != NULL)
+            done++;
+    }
+    else {
+        struct arena_t *arena = arena_enter_thread();
+        done = malloc_batch_locked(size, count, out);
+        arena_leave(arena);
+        if(done < count && arena != &arenas[0]){
+            arena_enter(&arenas[0]);
+            done += malloc_batch_locked(size, count - done, out + done);
+            arena_leave(&arenas[0]);
         }
     }
-    return NULL;
+    if(done != 0){
+        counter_add(&counters.mallocs, done);
+        histogram_malloc(out[0], size, done);
+    }
+    return done;
 }
 
-void heap_free(void* memblock)
+static int compare_pointers(const void* a, const void* b)
 {
-    typ_pointer = get_pointer_type(memblock);
-    if(typ_pointer != pointer_valid)
-        return;
-
-    int free_size = 0, size_true = 0, unused = 0;
-    struct memory_chunk_t *block = (struct memory_chunk_t*) ((uint8_t*)memblock - size_ch - FENCE);
-    if(block->free == 1) return;
-
-    memset((uint8_t*)block + size_ch,'?', FENCE);
-    memset((uint8_t*)block + size_ch + FENCE + block->size,'?', FENCE);
-
-    block->free = 1;
-    free_size = block->size + 2*FENCE;
+    uintptr_t x = (uintptr_t)*(void* const*)a, y = (uintptr_t)*(void* const*)b;
+    return (x > y) - (x < y);
+}
 
-    if(block->next) {
-        uint8_t *wsk = (uint8_t*)block + size_ch + 2*FENCE + block->size;
-        while(wsk < (uint8_t*)block->next){
-            unused++;
-            wsk++;
-        }
-        block->size += unused;
-        free_size += unused;
-    }
-    size_true = free_size;
-
-    if((block->prev != NULL && block->next != NULL) && (block->prev->free == 1 && block->next->free == 1)){
-        free_size += 2*size_ch;
-        size_true += size_ch + block->prev->size;
-        size_true += size_ch + block->next->size;
-        if (block->next->next == NULL && block->prev->prev != NULL) // ostatnie bloki Ffff...'Bbbb'...
-        {
-            free_size += size_ch;
-            block->prev->prev->next = NULL;
-            block->prev->prev->sum_control = 0;
-            block->prev->prev->sum_control = fun_sum_control(block->prev->prev);
-            memory_manager.memory_size += free_size;
-            return;
-        }
-        block->prev->size = size_true;
-        block->prev->next = block->next->next;
-        if(block->next->next != NULL) {
-            block->next->next->prev = block->prev;
-            block->next->next->sum_control = 0;
-            block->next->next->sum_control = fun_sum_control(block->next->next);
-        }
-        block->prev->sum_control = 0;
-        block->prev->sum_control = fun_sum_control(block->prev);
-    }
-    else if(block->prev != NULL && block->prev->free == 1){    //Fff...'Ccc'
-        free_size += size_ch;
-        size_true += size_ch + block->prev->size;
-        if(block->next == NULL && block->prev->prev != NULL) //Fff...'Ccc'...
-        {
-            free_size += size_ch;
-            block->prev->prev->next = NULL;
-            block->prev->prev->sum_control = 0;
-            block->prev->prev->sum_control = fun_sum_control(block->prev->prev);
-            memory_manager.memory_size += free_size;
-            return;
-        }
-        block->prev->size = size_true;
-        block->prev->next = block->next;
-        if(block->next != NULL) {
-            block->next->prev = block->prev;
-            block->next->sum_control = 0;
-            block->next->sum_control = fun_sum_control(block->next);
-        }
-        block->prev->sum_control = 0;
-        block->prev->sum_control = fun_sum_control(block->prev);
-    }
-    else if(block->next != NULL && block->next->free == 1){ //FffBbb'Ccc'D...
-        free_size += size_ch;
-        size_true += size_ch + block->next->size;
-        if(block->next->next == NULL && block->prev != NULL)  //FffBbb'Ccc'...
-        {
-            free_size += size_ch;
-            block->prev->next = NULL;
-            block->prev->sum_control = 0;
-            block->prev->sum_control = fun_sum_control(block->prev);
-            memory_manager.memory_size += free_size;
-            return;
+void heap_free_batch(void** ptrs, size_t count)
+{
+    if(ptrs == NULL) return;
+
+    // po posortowaniu bloki jednej areny leżą obok siebie, a sąsiedzi łączą się kolejno z poprzednikami
+    qsort(ptrs, count, sizeof(void*), compare_pointers);
+    // wskaźniki NULL są po sortowaniu na początku
+    size_t i = 0;
+    while(i < count && ptrs[i] == NULL)
+        i++;
+    if(i < count)
+        counter_add(&counters.frees, count - i);
+    for(size_t k = i; k < count; k++)
+        histogram_free(ptrs[k]);
+    while(i < count){
+        struct arena_t *arena = ptrs[i] != NULL ? arena_of(ptrs[i]) : NULL;
+        if(arena == NULL){
+            free_block(ptrs[i++]); // NULL, duże bloki i obce wskaźniki
+            continue;
         }
-        block->size = size_true;
-        if(block->next->next != NULL) {
-            block->next->next->prev = block;
-            block->next->next->sum_control = 0;
-            block->next->next->sum_control = fun_sum_control(block->next->next);
+
+        arena_enter(arena);
+        // pełna kontrola raz na serię, dla pozostałych bloków tylko nagłówek i płotki
+        typ_pointer = check_pointer(ptrs[i], 0);
+        if(typ_pointer == pointer_valid)
+            free_checked(ptrs[i]);
+        for(i++; i < count && arena_of(ptrs[i]) == arena; i++){
+            enum pointer_type_t type = heap_options.integrity == heap_integrity_off ? pointer_valid : chunk_check(ptrs[i]);
+            if(type == pointer_valid)
+                free_checked(ptrs[i]);
         }
-        block->next = block->next->next;
-    }
-    if(block->next == NULL && block->prev != NULL && block->prev->free == 0) //FffBbb'Ccc'...
-    {
-        free_size += size_ch;
-        block->prev->next = NULL;
-        block->prev->sum_control = 0;
-        block->prev->sum_control = fun_sum_control(block->prev);
-    }
-    block->size = size_true;
-    int fre = 0, n_block = 0;
-    struct memory_chunk_t *ptr = memory_manager.first_memory_chunk;
-    while (ptr){
-        if(ptr->free == 1)
-            fre++;
-        n_block++;
-        ptr = ptr->next;
-    }
-    if(fre == n_block) {
-        free_size += size_ch;
-        memory_manager.first_memory_chunk = NULL;
+        arena_leave(arena);
     }
-    block->sum_control = 0;
-    block->sum_control = fun_sum_control(block);
-
-    memory_manager.memory_size += free_size - unused;
 }
 
 int fun_sum_control(const struct memory_chunk_t* block)
 {
-    int s = 0;
-    uint8_t *p = (uint8_t*) block;
-    for (int i = 0; i < (int)size_ch; i++) {
-        s+= *p++;
+    struct arena_t *arena = arena_of(block);
+    if(arena == NULL)
+        arena = &arenas[0];
+    return chunk_sum(block, arena->manager->sum_key);
+}
+
+// Bloki w pamięci podręcznej wątków liczą się jako zajęte
+static size_t largest_used_locked(void)
+{
+    if(manager->memory_start == NULL) return 0;
+    // przy pełnej kontroli uszkodzona sterta nie ma największego bloku
+    if(heap_options.integrity == heap_integrity_full && validate_heap() != 0)
+        return 0;
+    intptr_t largest = maxima_largest(MAXIMA_USED);
+    if(largest >= 0)
+        return (size_t)largest;
+
+    size_t size = slab_largest_used();
+    for(struct memory_chunk_t *block = manager->first_memory_chunk; block != NULL; block = chunk_next(block))
+        if(!chunk_free(block) && block->size > size)
+            size = block->size;
+    return size;
+}
+
+static size_t largest_free_locked(void)
+{
+    if(manager->memory_start == NULL) return 0;
+    if(heap_options.integrity == heap_integrity_full && validate_heap() != 0)
+        return 0;
+    intptr_t largest = maxima_largest(MAXIMA_FREE);
+    if(largest < 0){
+        largest = 0;
+        for(struct memory_chunk_t *block = manager->first_memory_chunk; block != NULL; block = chunk_next(block))
+            if(chunk_free(block) && block->size > (size_t)largest)
+                largest = block->size;
     }
-    return s;
+    // wolny koniec sterty za ostatnim blokiem przyjmie blok z nagłówkiem bez powiększania sterty
+    size_t tail = (size_t)((uint8_t*)manager->memory_start + manager->memory_size - heap_tail());
+    if(tail > size_ch && tail - size_ch > (size_t)largest)
+        largest = (intptr_t)(tail - size_ch);
+    // pojemność wolnego bloku obejmuje też płotki nowego bloku
+    return (size_t)largest > 2 * FENCE ? (size_t)largest - 2 * FENCE : 0;
 }
 
 size_t heap_get_largest_used_block_size(void)
 {
-    if(memory_manager.memory_start == NULL || memory_manager.first_memory_chunk == NULL) return 0;
-    int val = heap_validate();
-    if(val == 1 || val == 2 || val == 3) return 0;
     size_t size = 0;
-    struct memory_chunk_t *the_largest_block = memory_manager.first_memory_chunk;
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        arena_enter(&arenas[i]);
+        remote_drain(&arenas[i]);
+        size_t arena_size = largest_used_locked();
+        arena_leave(&arenas[i]);
+        if(arena_size > size)
+            size = arena_size;
+    }
+    // lista dużych bloków jest uporządkowana malejąco według rozmiaru
+    pthread_mutex_lock(&large_lock);
+    if(large_list != NULL && (heap_options.integrity != heap_integrity_full || large_validate_locked() == 0))
+        if(large_list->size > size)
+            size = large_list->size;
+    pthread_mutex_unlock(&large_lock);
+    return size;
+}
 
-    while (the_largest_block && the_largest_block->free == 1) {
-        the_largest_block = the_largest_block->next;
+size_t heap_get_largest_free_block_size(void)
+{
+    size_t size = 0;
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        arena_enter(&arenas[i]);
+        remote_drain(&arenas[i]);
+        size_t arena_size = largest_free_locked();
+        arena_leave(&arenas[i]);
+        if(arena_size > size)
+            size = arena_size;
     }
-    if(the_largest_block) {
-        size = the_largest_block->size;
-        while (the_largest_block) {
-            if (the_largest_block->next)
-                if (the_largest_block->next->free == 0 && the_largest_block->next->size > size)
-                    size = the_largest_block->next->size;
+    return size;
+}
 
-            the_largest_block = the_largest_block->next;
+void heap_get_stats(struct heap_stats_t* stats)
+{
+    if(stats == NULL) return;
+    memset(stats, 0, sizeof(struct heap_stats_t));
+
+    for(int i = 0; i < HEAP_MAX_ARENAS; i++){
+        arena_enter(&arenas[i]);
+        remote_drain(&arenas[i]);
+        if(manager->memory_start != NULL){
+            size_t chunks = manager->chunk_count[MAXIMA_USED] + manager->chunk_count[MAXIMA_FREE];
+            size_t tail = (size_t)(heap_tail() - (uint8_t*)manager->memory_start);
+            stats->allocated += manager->chunk_bytes[MAXIMA_USED] + manager->slab_bytes;
+            stats->free += manager->chunk_bytes[MAXIMA_FREE] + manager->memory_size - tail;
+            stats->metadata += chunks * size_ch + manager->slab_top / PAGE * size_slab;
+            stats->fences += manager->fence_bytes;
+            stats->footprint += manager->memory_size + manager->slab_top;
+            stats->chunks += chunks;
+            if(manager->memory_reserved == 0)
+                stats->brk += manager->memory_size;
         }
+        arena_leave(&arenas[i]);
     }
-    return size;
+
+    pthread_mutex_lock(&large_lock);
+    stats->allocated += large_total.bytes;
+    stats->metadata += large_count * size_large;
+    stats->fences += large_total.fences;
+    stats->footprint += large_total.length;
+    stats->chunks += large_count;
+    pthread_mutex_unlock(&large_lock);
+    stats->slack = stats->footprint - stats->allocated - stats->free - stats->metadata - stats->fences;
+
+    pthread_mutex_lock(&counters_lock);
+    struct heap_counters_t sum = counters_sum();
+    stats->mallocs = sum.mallocs - counters_base.mallocs;
+    stats->frees = sum.frees - counters_base.frees;
+    stats->reallocs = sum.reallocs - counters_base.reallocs;
+    pthread_mutex_unlock(&counters_lock);
 }
 
-enum pointer_type_t get_pointer_type(const void* const pointer)
+void heap_get_histogram(struct heap_histogram_t* histogram)
+{
+    if(histogram == NULL) return;
+    pthread_mutex_lock(&counters_lock);
+    struct heap_counters_t sum = counters_sum();
+    for(int i = 0; i < HEAP_BIN_COUNT; i++)
+        histogram->sizes[i] = sum.sizes[i] - counters_base.sizes[i];
+    for(int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+        histogram->lifetimes[i] = sum.lifetimes[i] - counters_base.lifetimes[i];
+    pthread_mutex_unlock(&counters_lock);
+}
+
+// Najmniejszy rozmiar przedziału - odwrotność bin_index
+size_t heap_histogram_bucket_size(int bucket)
+{
+    if(bucket < 0 || bucket >= HEAP_BIN_COUNT) return 0;
+    if(bucket < 16)
+        return (size_t)bucket << 4;
+    int fl = 8 + ((bucket - 16) >> 2);
+    return ((size_t)1 << fl) + ((size_t)((bucket - 16) & 3) << (fl - 2));
+}
+
+void heap_histogram_dump(FILE* stream)
+{
+    if(stream == NULL) return;
+    struct heap_histogram_t histogram;
+    heap_get_histogram(&histogram);
+
+    fprintf(stream, "%12s %12s\n", "rozmiar od", "przydziały");
+    for(int i = 0; i < HEAP_BIN_COUNT; i++)
+        if(histogram.sizes[i] != 0)
+            fprintf(stream, "%12zu %12llu\n", heap_histogram_bucket_size(i), (unsigned long long)histogram.sizes[i]);
+    fprintf(stream, "%12s %12s\n", "życie od [ns]", "próbki");
+    for(int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+        if(histogram.lifetimes[i] != 0)
+            fprintf(stream, "%12llu %12llu\n", 1ull << i, (unsigned long long)histogram.lifetimes[i]);
+}
+
+// Położenie wskaźnika względem bloku, w którego obszarze leży
+static enum pointer_type_t chunk_classify(const struct memory_chunk_t* block, const uint8_t* point)
+{
+    // wolny blok w całości, z nagłówkiem, jest nieprzydzieloną pamięcią
+    if (chunk_free(block))
+        return pointer_unallocated;
+
+    intptr_t dist = point - (const uint8_t*)block;
+    intptr_t start = 0;
+    if (dist >= start && dist < (intptr_t)size_ch)
+        return pointer_control_block;
+
+    start = size_ch;
+    if (dist >= start && dist < start + FENCE)
+        return *point == '#' ? pointer_inside_fences : pointer_unallocated;
+
+    start += FENCE;
+    if(dist == start)
+        return pointer_valid;
+    else if (dist > start && dist < start + (intptr_t)block->size)
+        return pointer_inside_data_block;
+
+    start += block->size;
+    if (dist >= start && (dist < start + (intptr_t)fence_after(block->size)) && *point == '#')
+        return pointer_inside_fences;
+    return pointer_unallocated;
+}
+
+static enum pointer_type_t pointer_type(const void* pointer)
 {
     if(pointer == NULL) return pointer_null;
-    int value = heap_validate();
+    int value = validate_heap();
     if(value == 1 || value == 2 || value == 3)  return pointer_heap_corrupted;
-    if(memory_manager.first_memory_chunk == NULL) return pointer_unallocated;;
+    struct slab_t *slab = slab_of(manager, pointer);
+    if(slab != NULL) return slab_pointer_type(slab, pointer);
+    if(manager->first_memory_chunk == NULL) return pointer_unallocated;;
 
     uint8_t *point = (uint8_t*)pointer;
-    int dist = 0;
-    struct memory_chunk_t *block = memory_manager.first_memory_chunk;
+    struct memory_chunk_t *block = manager->first_memory_chunk;
 
     while (block)
     {
-        dist = point - (uint8_t*)block;
-
-        int start = 0;
-        if (dist >= start && dist < (int)size_ch)
-            return pointer_control_block;
-
-        start = size_ch;
-        if (dist >= start && dist < start + FENCE && *(char*)pointer == '#')
-            return pointer_inside_fences;
-
-        start += FENCE;
-        if((dist == start) && (block->free == 0))
-            return pointer_valid;
-        else if (dist > start && (dist < start + (int)block->size) && (block->free == 0))
-            return pointer_inside_data_block;
-
-        start += block->size;
-        if (dist >= start && (dist < start + FENCE ) && *(char*)pointer == '#')
-            return pointer_inside_fences;
-
-        block = block->next;
+        if (point >= (uint8_t*)block && point < (uint8_t*)block + chunk_span(block))
+            return chunk_classify(block, point);
+        block = chunk_next(block);
     }
     return pointer_unallocated;
 }
 
-int heap_validate(void)
+// Klasyfikacja przez mapę stron: sprawdzany jest tylko blok, w którym leży wskaźnik
+static enum pointer_type_t pointer_lookup(const void* pointer)
 {
-    if (memory_manager.memory_start == NULL) return 2;
-    if(memory_manager.first_memory_chunk == NULL) return 0;
+    if(pointer == NULL) return pointer_null;
+    if(manager->memory_start == NULL) return pointer_heap_corrupted;
+    struct slab_t *slab = slab_of(manager, pointer);
+    if(slab != NULL) return slab_pointer_type(slab, pointer);
 
-    struct memory_chunk_t *heap = memory_manager.first_memory_chunk;
-    int l = 0;
+    uint8_t *point = (uint8_t*)pointer;
+    if(point < (uint8_t*)manager->memory_start || point >= heap_tail())
+        return pointer_unallocated;
+    struct heap_page_t *page = page_entry(point);
+    if(page == NULL)
+        return pointer_type(pointer);
+
+    // bloki zaczynające się na tej stronie przed wskaźnikiem, a gdy ich nie ma - blok obejmujący początek strony
+    struct memory_chunk_t *block = page_block(page->first);
+    if(block != NULL && (uint8_t*)block <= point){
+        for(struct memory_chunk_t *next = chunk_next(block); next != NULL && (uint8_t*)next <= point; next = chunk_next(next))
+            block = next;
+    }
+    else if((block = page_block(page->used)) == NULL)
+        return pointer_unallocated;
 
-    while(heap) {
-        struct memory_chunk_t temp;
-        memcpy(&temp,heap, size_ch);
-        temp = *heap;
+    if(!chunk_sum_ok(block))
+        return pointer_heap_corrupted;
+    return chunk_classify(block, point);
+}
 
-        int sum_b = 0;
-        temp.sum_control = 0;
-        uint8_t *b = (uint8_t*)&temp;
-        for (int i = 0; i < (int)size_ch; i++) {
-            sum_b += *b;
-            b++;
-        }
-        if(heap->sum_control != sum_b)
-            return 3;
+enum pointer_type_t get_pointer_type(const void* const pointer)
+{
+    if(pointer != NULL && arena_of(pointer) == NULL && __atomic_load_n(&large_count, __ATOMIC_RELAXED) != 0){
+        pthread_mutex_lock(&large_lock);
+        struct large_t *large = large_find(pointer);
+        enum pointer_type_t type = large ? large_pointer_type(large, pointer) : pointer_unallocated;
+        pthread_mutex_unlock(&large_lock);
+        if(large != NULL)
+            return type;
+    }
 
-        if(heap->free == 1){
-            heap = heap->next;
-            continue;
-        }
-        char *wsk = (char *)heap;
-        wsk = wsk + size_ch;
-        while (*wsk == '#' && l < FENCE) {
-            l++;
-            wsk++;
-        }
-        if (l != FENCE)
-            return 1;
+    struct arena_t *arena = arena_enter_pointer(pointer);
+    enum pointer_type_t type = pointer_lookup(pointer);
+    arena_leave(arena);
+    return type;
+}
 
-        while (*(wsk + heap->size) == '#' && l < 2*FENCE) {
-            l++;
-            wsk++;
-        }
-        if (l != 2*FENCE)
+// Suma kontrolna nagłówka i płotki zajętego bloku
+static int chunk_validate(const struct memory_chunk_t* block)
+{
+    if(!chunk_sum_ok(block))
+        return 3;
+    if(chunk_free(block))
+        return 0;
+    const uint8_t *data = (const uint8_t*)block + size_ch + FENCE;
+    for(int i = 0; i < FENCE; i++)
+        if(data[-FENCE + i] != '#')
+            return 1;
+    for(size_t i = 0; i < fence_after(block->size); i++)
+        if(data[block->size + i] != '#')
             return 1;
-
-        heap = heap->next;
-        l = 0;
-    }
     return 0;
 }
 
-int unused_size(void* memblock)
+static int validate_heap(void)
 {
-    struct memory_chunk_t *block = (struct memory_chunk_t*) ((uint8_t*)memblock - size_ch - FENCE);
-    int unused = 0;
-    if(block->next) {
-        uint8_t *wsk = (uint8_t*)block + size_ch + 2*FENCE + block->size;
-        while(wsk < (uint8_t*)block->next){
-            unused++;
-            wsk++;
-        }
+    if (manager->memory_start == NULL) return 2;
+    if(slab_validate() != 0) return 3;
+
+    for(struct memory_chunk_t *heap = manager->first_memory_chunk; heap != NULL; heap = chunk_next(heap)){
+        int status = chunk_validate(heap);
+        if(status != 0)
+            return status;
     }
-    return unused;
+    return 0;
 }
 
-void* heap_malloc_aligned(size_t count)
+int heap_validate(void)
 {
-    size_t size = count;
-    if(size <= 0 ) return NULL;
-    size_t size_free_L = 0,size_free_R = 0,size_L = 0,free_R = 0;
-
-    struct memory_chunk_t *block = memory_manager.first_memory_chunk;
-    uint8_t *ptr = NULL;
-    short flag = 0;
-    int ile = 0;
-    while (block) {
-        ile = 0;
-        flag = 0;
-        size_L = 0;
-        free_R = 0;
-        if (block->free == 1) {
-            if (size + 2*FENCE < block->size)
-            {
-                ptr = (uint8_t *)block + size_ch + FENCE;
-                while (ptr < ((uint8_t*)block + size_ch + block->size - FENCE)) {
-                    if (((intptr_t)ptr & (intptr_t)(PAGE - 1)) == 0) {
-                        flag = 1;
-                        break;
-                    }
-                    ptr++;
-                    ile++;
-                }
-                if(flag == 1){
-                    if((struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE) == block->next){
-                        flag = 0;
-                        block = block->next;
-                        continue;
-                    }
-                    size_free_L = (uint8_t *)ptr - (uint8_t *)block;
-                    size_free_R = block->size - size_free_L;
-
-                    size_L = size_free_L - size_ch - FENCE;
-                    if (size_L > 0 && size_L < size_ch){
-                        block = block->next;
-                        flag = 0;
-                        continue;
-                    }
-                    else if (size_L > size_ch)
-                        size_L = size_L - size_ch;
-
-                    free_R = 0;
-                    if (block->next == NULL)
-                        free_R = 0;
-                    else if (block->size >= (size_free_L + size + FENCE + size_ch))
-                        free_R = block->size - (size_free_L + size + FENCE + size_ch);
-                    else {
-                        block = block->next;
-                        flag = 0;
-                        continue;
-                    }
-                    if (flag == 1)
-                        break;
-                }
-            }
-        }
-        block = block->next;
+    arena_enter(&arenas[0]);
+    int status = validate_heap();
+    if(status == 0)
+        remote_drain(&arenas[0]);
+    arena_leave(&arenas[0]);
+    // dodatkowe areny sprawdzane są tylko wtedy, gdy istnieją
+    for(int i = 1; i < HEAP_MAX_ARENAS && status == 0; i++){
+        arena_enter(&arenas[i]);
+        if(manager->memory_start != NULL)
+            status = validate_heap();
+        if(status == 0)
+            remote_drain(&arenas[i]);
+        arena_leave(&arenas[i]);
     }
-
-    if (memory_manager.first_memory_chunk == NULL || flag == 0)
-    {
-        size_t siz_need = size + size_ch + 2*FENCE;
-        siz_need = align_size(siz_need);
-
-        void *ptr_sbrk = custom_sbrk(siz_need);
-        if(ptr_sbrk == (void*)-1)
-            return NULL;
-        memory_manager.memory_size += siz_need;
+    if(status == 0 && __atomic_load_n(&large_count, __ATOMIC_RELAXED) != 0){
+        pthread_mutex_lock(&large_lock);
+        status = large_validate_locked();
+        pthread_mutex_unlock(&large_lock);
     }
+    return status;
+}
 
-    struct memory_chunk_t *first_block = memory_manager.first_memory_chunk;
-
-    if(first_block == NULL){
-        first_block = (struct memory_chunk_t*)memory_manager.memory_start;
-        first_block->free = 1;
-        first_block->size = PAGE - 2 * size_ch - FENCE;
-        first_block->prev = NULL;
-        first_block->next = NULL;
-        first_block->sum_control = 0;
-        first_block->sum_control = fun_sum_control(first_block);
+//
+// Kursor walidacji po kawałku: arena, następny blok do sprawdzenia i wersja areny z chwili zapisu.
+// Gdy wersja się zmieniła, blok pod kursorem mógł zostać scalony z sąsiadem - przejście wznawia się
+// od bloku obejmującego ten adres, znalezionego przez mapę stron.
+// Dla i == HEAP_MAX_ARENAS kursor wskazuje listę dużych bloków.
+static struct
+{
+    pthread_mutex_t lock;
+    uint64_t generation;
+    int arena;
+    uint8_t *point;
+    uint64_t version;
+} validate_cursor = { PTHREAD_MUTEX_INITIALIZER, 0, 0, NULL, 0 };
+
+// Blok obejmujący point albo pierwszy blok areny, gdy mapa stron go nie obejmuje
+static struct memory_chunk_t* validate_resume(uint8_t* point)
+{
+    if(point == NULL)
+        return manager->first_memory_chunk;
+    if(point >= heap_tail())
+        return NULL;
+    if(validate_cursor.version == manager->version)
+        return (struct memory_chunk_t*)point;
+    if(page_entry(point) == NULL)
+        return manager->first_memory_chunk;
+
+    // ostatni początek bloku nie dalej niż point
+    size_t page = (size_t)(point - (uint8_t*)manager->memory_start) / PAGE;
+    struct memory_chunk_t *block = page_block(manager->page_map[page].first);
+    while((block == NULL || (uint8_t*)block > point) && page > 0)
+        block = page_block(manager->page_map[--page].first);
+    if(block == NULL || (uint8_t*)block > point)
+        block = manager->first_memory_chunk;
+    for(struct memory_chunk_t *next = chunk_next(block); next != NULL && (uint8_t*)next <= point; next = chunk_next(next))
+        block = next;
+    return block;
+}
 
-        memory_manager.memory_size -= size_ch;
-        memory_manager.first_memory_chunk = first_block;
+int heap_validate_step(size_t budget)
+{
+    pthread_mutex_lock(&validate_cursor.lock);
+    uint64_t generation = __atomic_load_n(&heap_generation, __ATOMIC_ACQUIRE);
+    if(validate_cursor.generation != generation){
+        validate_cursor.generation = generation;
+        validate_cursor.arena = 0;
+        validate_cursor.point = NULL;
     }
 
-    if(flag == 1){
-        struct memory_chunk_t block_ok;
-        memcpy(&block_ok,block,size_ch);
-
-        struct memory_chunk_t *block_aligned = (struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE);
-
-        if(size_free_L == size_ch + FENCE && size_free_R == size + FENCE){
-            block->size = size;
-            block->free = 0;
-            memset((uint8_t*)block+ size_ch,'#', FENCE);
-            memset((uint8_t*)block + size_ch + size + FENCE,'#', FENCE);
-
-            block->sum_control = 0;
-            block->sum_control = fun_sum_control(block);
-
-            memory_manager.memory_size += -size - 2*FENCE;
-            typ_pointer = get_pointer_type((uint8_t*)block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)block + size_ch + FENCE;
-
-            return NULL;
+    int status = -1;
+    while(status < 0 && budget > 0){
+        if(validate_cursor.arena == HEAP_MAX_ARENAS){
+            // duże bloki na końcu przejścia, w jednym kroku
+            pthread_mutex_lock(&large_lock);
+            status = large_validate_locked();
+            pthread_mutex_unlock(&large_lock);
+            break;
         }
-        else {
-            block_aligned->size = size;
-            block_aligned->free = 0;
-            memset((uint8_t*)block_aligned+ size_ch,'#', FENCE);
-            memset((uint8_t*)block_aligned + size_ch + size + FENCE,'#', FENCE);
-
-            if (size_L > 0) {
-                if(block->prev && block->prev->free == 1){
-                    block->prev->size += size_L + size_ch;
-                    block_aligned->next = block->next;
-                    block->next->prev = block_aligned;
-
-                    block->prev->next = block_aligned;
-                    block_aligned->prev = block->prev;
-
-                    block->prev->sum_control = 0;
-                    block->prev->sum_control = fun_sum_control(block->prev);
-                    block_aligned->next->sum_control = 0;
-                    block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-
-                    memory_manager.memory_size += size_L + size_ch;
-                }
-                else {
-                    block->size = size_L;
-                    block->free = 1;
-                    block_aligned->next = block->next;
-                    block->next->prev = block_aligned;
-
-                    block_aligned->prev = block;
-                    block->next = block_aligned;
-
-                    block->sum_control = 0;
-                    block->sum_control = fun_sum_control(block);
-                    block_aligned->next->sum_control = 0;
-                    block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-                }
-            }
 
-            if (free_R > 0 && block_ok.next && block_ok.next->free == 0) {
-
-                struct memory_chunk_t *block_free_R = (struct memory_chunk_t *) ((uint8_t *) ptr + size + FENCE);
-                block_free_R->size = free_R;
-                block_free_R->free = 1;
-
-                if (size_free_L == size_ch + FENCE) {
-                    block_free_R->next = block->next;
-                    block->next->prev = block_free_R;
-                    block_free_R->prev = block_aligned;
-                    block_aligned->next = block_free_R;
-
-                    block_free_R->sum_control = 0;
-                    block_free_R->sum_control = fun_sum_control(block_free_R);
-                    block_free_R->next->sum_control = 0;
-                    block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                }
-                if (size_L > 0) {
-                    block_free_R->next = block_aligned->next;
-                    block_aligned->next->prev = block_free_R;
-                    block_free_R->prev = block_aligned;
-                    block_aligned->next = block_free_R;
-
-                    block_free_R->sum_control = 0;
-                    block_free_R->sum_control = fun_sum_control(block_free_R);
-                    block_free_R->next->sum_control = 0;
-                    block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                }
-                memory_manager.memory_size += -size_ch;
-            }
-            block_aligned->sum_control = 0;
-            block_aligned->sum_control = fun_sum_control(block_aligned);
-
-            if(block_aligned != block)
-                memory_manager.memory_size += -size_ch;
-            memory_manager.memory_size += - size - 2*FENCE;
-
-            typ_pointer = get_pointer_type((uint8_t*)block_aligned + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)block_aligned + size_ch + FENCE;
-            return NULL;
+        struct arena_t *arena = &arenas[validate_cursor.arena];
+        arena_enter(arena);
+        if(manager->memory_start == NULL){
+            // bez heap_setup nie ma czego sprawdzać; dodatkowe areny mogą nie istnieć
+            if(validate_cursor.arena == 0)
+                status = 2;
+            validate_cursor.arena++;
+            arena_leave(arena);
+            continue;
         }
-    }
-    else{
-        struct memory_chunk_t *the_last_block = memory_manager.first_memory_chunk;
-        while (the_last_block->next) {
-            the_last_block = the_last_block->next;
+        struct memory_chunk_t *block = validate_resume(validate_cursor.point);
+        for(; block != NULL && budget > 0; block = chunk_next(block), budget--){
+            status = chunk_validate(block);
+            if(status != 0)
+                break;
+            status = -1;
         }
-        size_t offset = (uint8_t *)the_last_block - (uint8_t *)memory_manager.memory_start;
-        offset = offset + the_last_block->size + size_ch;
-        if (the_last_block->free == 0)
-            offset = offset + 2*FENCE;
-
-        if ((align_size(offset) - offset < size_ch + FENCE))
-        {
-            void* ptr_sbrk = custom_sbrk(PAGE);
-            if(ptr_sbrk == (void*)-1)
-                return NULL;
-            memory_manager.memory_size += PAGE;
-            offset = offset + PAGE;
+        if(status < 0 && block == NULL){
+            if(slab_validate() != 0)
+                status = 3;
+            validate_cursor.arena++;
+            validate_cursor.point = NULL;
         }
+        else if(status < 0){
+            validate_cursor.point = (uint8_t*)block;
+            validate_cursor.version = manager->version;
+        }
+        arena_leave(arena);
+    }
 
-        offset = align_size(offset);
-        offset += -size_ch - FENCE;
-
-        void* ptr_sbrk_last = custom_sbrk(0);
-        if((uint8_t*)memory_manager.memory_start + offset + size_ch + 2*FENCE + size >= (uint8_t*)ptr_sbrk_last)
-            return NULL;
-
-        struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)memory_manager.memory_start + offset);
-        memset((uint8_t*)next_block + size_ch,'#', FENCE);
-        memset((uint8_t*)next_block + size_ch + size + FENCE,'#', FENCE);
-        next_block->size = size;
-        next_block->free = 0;
-        next_block->next = NULL;
-        next_block->prev = the_last_block;
-        the_last_block->next = next_block;
-
-        next_block->sum_control = 0;
-        next_block->sum_control = fun_sum_control(next_block);
-        the_last_block->sum_control = 0;
-        the_last_block->sum_control = fun_sum_control(the_last_block);
-
-        memory_manager.memory_size += -size - size_ch - 2*FENCE;
-
-        typ_pointer = get_pointer_type((uint8_t*)next_block + size_ch + FENCE);
-        if(typ_pointer == pointer_valid)
-            return (uint8_t*)next_block + size_ch + FENCE;
-        return NULL;
+    // koniec przejścia albo błąd - następne wywołanie zaczyna od początku
+    if(status >= 0){
+        validate_cursor.arena = 0;
+        validate_cursor.point = NULL;
     }
+    pthread_mutex_unlock(&validate_cursor.lock);
+    return status;
 }
 
-void* heap_calloc_aligned(size_t number, size_t size_of)
+static struct
 {
-    if(number <= 0 || size_of <= 0) return NULL;
-    size_t size = number * size_of;
-    size_t size_free_L = 0, size_free_R = 0, size_L = 0, free_R = 0;
-    struct memory_chunk_t *block = memory_manager.first_memory_chunk;
-
-    uint8_t *ptr = NULL;
-    short flag = 0;
-    int ile = 0;
-    while (block) {
-        ile = 0;
-        flag = 0;
-        size_L = 0;
-        free_R = 0;
-        if (block->free == 1) {
-            if (size + 2*FENCE < block->size)
-            {
-                ptr = (uint8_t *)block + size_ch + FENCE;
-                while (ptr < ((uint8_t*)block + size_ch + block->size - FENCE)) {
-                    if (((intptr_t)ptr & (intptr_t)(PAGE - 1)) == 0) {
-                        flag = 1;
-                        break;
-                    }
-                    ptr++;
-                    ile++;
-                }
-                if(flag == 1){
-                    if((struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE) == block->next){
-                        flag = 0;
-                        block = block->next;
-                        continue;
-                    }
-                    size_free_L = (uint8_t *)ptr - (uint8_t *)block;
-                    size_free_R = block->size - size_free_L;
-
-                    size_L = size_free_L - size_ch - FENCE;
-                    if (size_L > 0 && size_L < size_ch){
-                        block = block->next;
-                        flag = 0;
-                        continue;
-                    }
-                    else if (size_L > size_ch)
-                        size_L = size_L - size_ch;
-
-                    free_R = 0;
-                    if (block->next == NULL)
-                        free_R = 0;
-                    else if (block->size >= (size_free_L + size + FENCE + size_ch))
-                        free_R = block->size - (size_free_L + size + FENCE + size_ch);
-                    else {
-                        block = block->next;
-                        flag = 0;
-                        continue;
-                    }
-                    if (flag == 1)
-                        break;
-                }
-            }
-        }
-        block = block->next;
-    }
-
-    if (memory_manager.first_memory_chunk == NULL || flag == 0)
-    {
-        size_t siz_need = size + size_ch + 2*FENCE;
-        siz_need = align_size(siz_need);
-
-        void *ptr_sbrk = custom_sbrk(siz_need);
-        if(ptr_sbrk == (void*)-1)
-            return NULL;
-        memory_manager.memory_size += siz_need;
+    pthread_t thread;
+    int running;
+    int status;
+    size_t budget;
+    unsigned period_ms;
+} validate_background;
+
+static void* validate_background_main(void* arg)
+{
+    (void)arg;
+    struct timespec period = { validate_background.period_ms / 1000, (long)(validate_background.period_ms % 1000) * 1000000 };
+    while(__atomic_load_n(&validate_background.running, __ATOMIC_ACQUIRE)){
+        int status = heap_validate_step(validate_background.budget);
+        // 2 oznacza stertę bez heap_setup, nie uszkodzenie
+        int none = 0;
+        if(status > 0 && status != 2)
+            __atomic_compare_exchange_n(&validate_background.status, &none, status, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+        nanosleep(&period, NULL);
     }
+    return NULL;
+}
 
-    struct memory_chunk_t *first_block = memory_manager.first_memory_chunk;
-
-    if(first_block == NULL){
-        first_block = (struct memory_chunk_t*)memory_manager.memory_start;
-        first_block->free = 1;
-        first_block->size = PAGE - 2 * size_ch - FENCE;
-        first_block->prev = NULL;
-        first_block->next = NULL;
-        first_block->sum_control = 0;
-        first_block->sum_control = fun_sum_control(first_block);
-
-        memory_manager.memory_size -= size_ch;
-        memory_manager.first_memory_chunk = first_block;
+int heap_validate_background_start(size_t budget, unsigned period_ms)
+{
+    if(budget == 0 || __atomic_load_n(&validate_background.running, __ATOMIC_ACQUIRE))
+        return -1;
+    validate_background.budget = budget;
+    validate_background.period_ms = period_ms;
+    __atomic_store_n(&validate_background.status, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&validate_background.running, 1, __ATOMIC_RELEASE);
+    if(pthread_create(&validate_background.thread, NULL, validate_background_main, NULL) != 0){
+        __atomic_store_n(&validate_background.running, 0, __ATOMIC_RELEASE);
+        return -1;
     }
+    return 0;
+}
 
-    if(flag == 1){
-        struct memory_chunk_t block_ok;
-        memcpy(&block_ok,block,size_ch);
-
-        struct memory_chunk_t *block_aligned = (struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE);
-
-        if(size_free_L == size_ch + FENCE && size_free_R == size + FENCE){
-            block->size = size;
-            block->free = 0;
-            memset((uint8_t*)block + size_ch,'#', FENCE);
-            memset((uint8_t*)block + size_ch + FENCE,0, size);
-            memset((uint8_t*)block + size_ch + size + FENCE,'#', FENCE);
+int heap_validate_background_status(void)
+{
+    return __atomic_load_n(&validate_background.status, __ATOMIC_ACQUIRE);
+}
 
-            block->sum_control = 0;
-            block->sum_control = fun_sum_control(block);
+int heap_validate_background_stop(void)
+{
+    if(!__atomic_load_n(&validate_background.running, __ATOMIC_ACQUIRE))
+        return heap_validate_background_status();
+    __atomic_store_n(&validate_background.running, 0, __ATOMIC_RELEASE);
+    pthread_join(validate_background.thread, NULL);
+    return heap_validate_background_status();
+}
 
-            memory_manager.memory_size += -size - 2*FENCE;
-            typ_pointer = get_pointer_type((uint8_t*)block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)block + size_ch + FENCE;
-            return NULL;
-        }
-        else {
-            block_aligned->size = size;
-            block_aligned->free = 0;
-            memset((uint8_t*)block_aligned+ size_ch,'#', FENCE);
-            memset((uint8_t*)block_aligned + size_ch + FENCE,0, size);
-            memset((uint8_t*)block_aligned + size_ch + size + FENCE,'#', FENCE);
-
-            if (size_L > 0) {
-                if(block->prev && block->prev->free == 1){
-                    block->prev->size += size_L + size_ch;
-                    block_aligned->next = block->next;
-                    block->next->prev = block_aligned;
-
-                    block->prev->next = block_aligned;
-                    block_aligned->prev = block->prev;
-
-                    block->prev->sum_control = 0;
-                    block->prev->sum_control = fun_sum_control(block->prev);
-                    block_aligned->next->sum_control = 0;
-                    block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-
-                    memory_manager.memory_size += size_L + size_ch;
-                }
-                else {
-                    block->size = size_L;
-                    block->free = 1;
-
-                    block_aligned->next = block->next;
-                    block->next->prev = block_aligned;
-
-                    block_aligned->prev = block;
-                    block->next = block_aligned;
-
-                    block->sum_control = 0;
-                    block->sum_control = fun_sum_control(block);
-                    block_aligned->next->sum_control = 0;
-                    block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-                }
-            }
+int unused_size(void* memblock)
+{
+    struct memory_chunk_t *block = (struct memory_chunk_t*) ((uint8_t*)memblock - size_ch - FENCE);
+    return (int)(chunk_span(block) - chunk_need(block->size));
+}
 
-            if (free_R > 0 && block_ok.next && block_ok.next->free == 0) {
-
-                struct memory_chunk_t *block_free_R = (struct memory_chunk_t *) ((uint8_t *) ptr + size + FENCE);
-                block_free_R->size = free_R;
-                block_free_R->free = 1;
-
-                if (size_free_L == size_ch + FENCE) {
-                    block_free_R->next = block->next;
-                    block->next->prev = block_free_R;
-                    block_free_R->prev = block_aligned;
-                    block_aligned->next = block_free_R;
-
-                    block_free_R->sum_control = 0;
-                    block_free_R->sum_control = fun_sum_control(block_free_R);
-                    block_free_R->next->sum_control = 0;
-                    block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                }
-                if (size_L > 0) {
-                    block_free_R->next = block_aligned->next;
-                    block_aligned->next->prev = block_free_R;
-                    block_free_R->prev = block_aligned;
-                    block_aligned->next = block_free_R;
-
-                    block_free_R->sum_control = 0;
-                    block_free_R->sum_control = fun_sum_control(block_free_R);
-                    block_free_R->next->sum_control = 0;
-                    block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                }
-                memory_manager.memory_size += -size_ch;
-            }
-            block_aligned->sum_control = 0;
-            block_aligned->sum_control = fun_sum_control(block_aligned);
+//
+// Wycięcie bloku z nagłówkiem w block_aligned z wolnego bloku block.
+// Lewa reszta zostaje wolnym blokiem albo (gdy jest za mała) nieużywaną przestrzenią poprzednika.
+static struct memory_chunk_t* chunk_carve(struct memory_chunk_t* block, struct memory_chunk_t* block_aligned)
+{
+    bin_remove(block);
+    if(block_aligned == block)
+        return block;
+
+    struct memory_chunk_t *prev = chunk_prev(block);
+    size_t span = chunk_span(block);
+    size_t size_L = (uint8_t*)block_aligned - (uint8_t*)block;
+    if(size_L >= size_ch + size_links){
+        block->span = (uint32_t)size_L | CHUNK_FREE;
+        block->size = (uint32_t)(size_L - size_ch);
+        set_sum_control(block);
+        bin_insert(block);
+        block_aligned->prev_size = (uint32_t)size_L;
+    }
+    else {
+        // nagłówki mogą na siebie nachodzić
+        prev->span += (uint32_t)size_L;
+        set_sum_control(prev);
+        block_aligned->prev_size = (uint32_t)chunk_span(prev);
+        page_first_remove(block, block_aligned);
+    }
+    block_aligned->span = CHUNK_FREE;
+    chunk_set_span(block_aligned, span - size_L);
+    page_first_add(block_aligned);
+    return block_aligned;
+}
 
-            if(block_aligned != block)
-                memory_manager.memory_size += -size_ch;
-            memory_manager.memory_size += - size - 2*FENCE;
+// Wyrównany adres danych w wolnym bloku; NULL gdy blok jest za mały
+static uint8_t* chunk_aligned_data(const struct memory_chunk_t* block, size_t alignment, size_t size)
+{
+    uint8_t *ptr = (uint8_t*)align_to((size_t)block + size_ch + FENCE, alignment);
+    size_t size_L = ptr - size_ch - FENCE - (uint8_t*)block;
+    // przerwa za mała na wolny blok dołącza do poprzednika, a bez poprzednika trzeba przesunąć dalej
+    if (size_L != 0 && size_L < size_ch + size_links && block->prev_size == 0)
+        ptr += alignment;
+    if (ptr + align16(size) + FENCE > (uint8_t*)block + chunk_span(block))
+        return NULL;
+    return ptr;
+}
 
-            typ_pointer = get_pointer_type((uint8_t*)block_aligned + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)block_aligned + size_ch + FENCE;
+static void* memalign_locked(size_t alignment, size_t size)
+{
+    if(manager->memory_start == NULL) return NULL;
 
+    // zapas na wyrównanie i wolny blok przed nim, więc wystarczy jeden blok z koszyka - jak w heap_malloc
+    uint8_t *ptr = NULL;
+    struct memory_chunk_t *block = bin_find(chunk_need(size) + alignment + size_ch + size_links);
+    if (block != NULL && (ptr = chunk_aligned_data(block, alignment, size)) == NULL)
+        block = NULL;
+
+    if (block != NULL) {
+        block = chunk_carve(block, (struct memory_chunk_t*)(ptr - size_ch - FENCE));
+        chunk_use(block, size);
+        chunk_split(block);
+    }
+    else {
+        uint8_t *tail = heap_tail();
+        struct memory_chunk_t *last = manager->last_memory_chunk;
+        uint8_t *start = (uint8_t*)align_to((size_t)tail + size_ch + FENCE, alignment) - size_ch - FENCE;
+        // na pustej stercie za mała przerwa nie ma poprzednika, do którego mogłaby dołączyć
+        if(last == NULL && start != tail && (size_t)(start - tail) < size_ch + size_links)
+            start += alignment;
+
+        if(heap_reserve(start, chunk_need(size)) != 0)
             return NULL;
+        if((size_t)(start - tail) >= size_ch + size_links){
+            // przestrzeń przed wyrównanym blokiem staje się wolnym blokiem
+            struct memory_chunk_t *gap = (struct memory_chunk_t*)tail;
+            gap->prev_size = last != NULL ? (uint32_t)chunk_span(last) : 0;
+            gap->span = (uint32_t)(start - tail) | CHUNK_FREE;
+            gap->size = (uint32_t)(start - tail - size_ch);
+            set_sum_control(gap);
+            if(last == NULL)
+                manager->first_memory_chunk = gap;
+            manager->last_memory_chunk = gap;
+            page_first_add(gap);
+            bin_insert(gap);
         }
+        block = chunk_append(start, size);
     }
-    else{
-        struct memory_chunk_t *the_last_block = memory_manager.first_memory_chunk;
-        while (the_last_block->next) {
-            the_last_block = the_last_block->next;
-        }
-
-        size_t offset = (uint8_t *)the_last_block - (uint8_t *)memory_manager.memory_start;
-        offset = offset + the_last_block->size + size_ch;
-        if (the_last_block->free == 0)
-            offset = offset + 2*FENCE;
-
-        if ((align_size(offset) - offset < size_ch + FENCE))
-        {
-            void* ptr_sbrk = custom_sbrk(PAGE);
-            if(ptr_sbrk == (void*)-1)
-                return NULL;
-            memory_manager.memory_size += PAGE;
-            offset = offset + PAGE;
-        }
 
-        offset = align_size(offset);
-        offset += -size_ch - FENCE;
+    typ_pointer = check_pointer((uint8_t*)block + size_ch + FENCE, 1);
+    if(typ_pointer == pointer_valid)
+        return (uint8_t*)block + size_ch + FENCE;
+    return NULL;
+}
 
-        void* ptr_sbrk_last = custom_sbrk(0);
-        if((uint8_t*)memory_manager.memory_start + offset + size_ch + 2*FENCE + size >= (uint8_t*)ptr_sbrk_last)
-            return NULL;
+void* heap_memalign(size_t alignment, size_t size)
+{
+    if(size <= 0 || size >= CHUNK_MAX_SPAN) return NULL;
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0 || alignment >= CHUNK_MAX_SPAN) return NULL;
+    // każdy blok jest wyrównany do ALIGN
+    if(alignment <= ALIGN)
+        return heap_malloc(size);
+
+    void *memblock = arena_malloc(alignment, size);
+    if(memblock != NULL)
+        counter_add(&counters.mallocs, 1);
+    histogram_malloc(memblock, size, 1);
+    return memblock;
+}
 
-        struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)memory_manager.memory_start + offset);
-        memset((uint8_t*)next_block + size_ch,'#', FENCE);
-        memset((uint8_t*)next_block + size_ch + FENCE,0, size);
-        memset((uint8_t*)next_block + size_ch + size + FENCE,'#', FENCE);
-        next_block->size = size;
-        next_block->free = 0;
-        next_block->next = NULL;
-        next_block->prev = the_last_block;
-        the_last_block->next = next_block;
+void* heap_aligned_alloc(size_t alignment, size_t size)
+{
+    return heap_memalign(alignment, size);
+}
 
-        next_block->sum_control = 0;
-        next_block->sum_control = fun_sum_control(next_block);
-        the_last_block->sum_control = 0;
-        the_last_block->sum_control = fun_sum_control(the_last_block);
+void* heap_malloc_aligned(size_t count)
+{
+    return heap_memalign(PAGE, count);
+}
 
-        memory_manager.memory_size += -size - size_ch - 2*FENCE;
+void* heap_calloc_aligned(size_t number, size_t size_of)
+{
+    if(number <= 0 || size_of <= 0) return NULL;
+    if(number > SIZE_MAX / size_of) return NULL;
+    size_t size = number * size_of;
 
-        typ_pointer = get_pointer_type((uint8_t*)next_block + size_ch + FENCE);
-        if(typ_pointer == pointer_valid)
-            return (uint8_t*)next_block + size_ch + FENCE;
+    block_zero = 0;
+    void *memblock = heap_malloc_aligned(size);
+    if(memblock == NULL)
         return NULL;
-    }
+    if(!block_zero)
+        zero_fill(memblock, size);
+    return memblock;
 }
 
 void* heap_realloc_aligned(void* memblock, size_t size)
 {
-    if(memory_manager.memory_start == NULL) return NULL;
     if(size == 0){
         heap_free(memblock);
         return NULL;
     }
-    uint8_t *ptr = NULL;
+    if(size >= CHUNK_MAX_SPAN) return NULL;
+    if(memblock == NULL)
+        return heap_malloc_aligned(size);
+    counter_add(&counters.reallocs, 1);
+
+    size_t old_size = 0;
+    void *new_memblock = NULL;
+    int status = -1;
+    // duże bloki nie są wyrównane do strony - zawsze przeniesienie na stertę
+    if(arena_of(memblock) == NULL && (old_size = large_size(memblock)) != 0)
+        status = -1;
+    else {
+        struct arena_t *arena = arena_enter_pointer(memblock);
+        status = realloc_locked(memblock, size, PAGE, &old_size, &new_memblock);
+        arena_leave(arena);
+    }
+    if(status == 0)
+        return histogram_realloc(memblock, memblock, size);
+    if(status == -2)
+        return NULL;
 
-    size_t size_free_L = 0,size_free_R = 0, size_L = 0,free_R = 0;;
-    int nextfree_R = 0;
-    short flag = 0, flagfind = 0;
+    new_memblock = arena_malloc(PAGE, size);
+    if(new_memblock == NULL)
+        return NULL;
+    memcpy(new_memblock, memblock, old_size < size ? old_size : size);
+    histogram_realloc(memblock, new_memblock, size);
+    free_block(memblock);
+    return new_memblock;
+}
 
-    typ_pointer = get_pointer_type(memblock);
-    if(typ_pointer == pointer_valid || typ_pointer == pointer_null)
-    {
-        if (memblock == NULL) {
-            void *m = heap_malloc_aligned(size);
-            return (uint8_t *) m;
-        }
-        int unused_memb = unused_size(memblock);
-
-        nextfree_R = 0;
-        struct memory_chunk_t *myblock = (struct memory_chunk_t *) ((uint8_t *)memblock - FENCE - size_ch);
-        if (myblock->next)
-        {
-            if (myblock->next->free == 1)
-                nextfree_R = myblock->next->size + size_ch;
-        }
-        ptr = (uint8_t *)myblock + size_ch + FENCE; //xl +FENCE
-
-        while (ptr < ((uint8_t*)myblock + size_ch + FENCE + myblock->size + FENCE + unused_memb + nextfree_R - FENCE)) {
-            flag = 0;
-            if (((intptr_t)ptr & (intptr_t)(PAGE - 1)) == 0) {
-                flag = 1;
-
-                size_free_L = (uint8_t *)ptr - (uint8_t *)myblock;
-                size_free_R = myblock->size - size_free_L;
-
-                size_L = size_free_L - size_ch - FENCE;
-                if (size_L > 0 && size_L < size_ch){
-                    flag = 0;
-                    ptr += PAGE;
-                    continue;
-                }
-                else if (size_L > size_ch)
-                    size_L = size_L - size_ch;
-
-                free_R = 0;
-                if (myblock->next == NULL)
-                    free_R = 0;
-                else if (myblock->size + unused_memb + nextfree_R >= (size_free_L + size + FENCE + size_ch))// 2*FENCE
-                    free_R = myblock->size + unused_memb + nextfree_R - (size_free_L + size + FENCE + size_ch);// +
-                else {
-                    flag = 0;
-                    ptr += PAGE;
-                    continue;
-                }
-                if (flag == 1) {
-                    break;
-                }
-            }
-            ptr++;
-        }
+//
+// Regiony: kawałki pamięci ze sterty połączone w listę. Reset cofa wskaźnik do pierwszego kawałka
+// i zostawia wszystkie kawałki do ponownego użycia, więc kosztuje O(1).
+struct region_chunk_t
+{
+    struct region_chunk_t* next;
+    size_t size;
+} __attribute__(( aligned(ALIGN) ));
 
-        struct memory_chunk_t *block_sea = NULL;
-        if (flag != 1) {
-            flagfind = 0;
-            block_sea = memory_manager.first_memory_chunk;
-
-            while (block_sea) {
-                flagfind = 0;
-                size_L = 0;
-                free_R = 0;
-
-                if (block_sea->free == 1 && block_sea->size >= size){
-                    ptr = (uint8_t *)block_sea + size_ch + FENCE;
-                    nextfree_R = 0;
-
-                    while (ptr < ((uint8_t*)block_sea + size_ch + block_sea->size - FENCE)) {
-                        if (((intptr_t)ptr & (intptr_t)(PAGE - 1)) == 0) {
-                            flagfind = 1;
-                            break;
-                        }
-                        ptr++;
-                    }
-                    if(flagfind == 1){
-                        if((struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE) == block_sea->next){
-                            flagfind = 0;
-                            block_sea = block_sea->next;
-                            continue;
-                        }
-                        size_free_L = (uint8_t *)ptr - (uint8_t *)block_sea;
-                        size_free_R = block_sea->size - size_free_L;
-
-                        size_L = size_free_L - size_ch - FENCE;
-                        if (size_L > 0 && size_L < size_ch){
-                            block_sea = block_sea->next;
-                            flagfind = 0;
-                            continue;
-                        }
-                        else if (size_L > size_ch)
-                            size_L = size_L - size_ch;
-
-                        free_R = 0;
-                        if (block_sea->next == NULL)
-                            free_R = 0;
-                        else if (block_sea->size >= (size_free_L + size + FENCE + size_ch))// +
-                            free_R = block_sea->size - (size_free_L + size + FENCE + size_ch);// +
-                        else {
-                            block_sea = block_sea->next;
-                            flagfind = 0;
-                            continue;
-                        }
-                        if (flagfind == 1) {
-                            break;
-                        }
-
-                    }
-                }
-                block_sea = block_sea->next;
-            }
-        }
-        struct memory_chunk_t *block = NULL;
-
-        if (flag == 1)
-            block = myblock;
-        else if (flagfind == 1)
-            block = block_sea;
-        else
-            block = NULL;
-
-        if (block != NULL) {
-            struct memory_chunk_t block_ok;
-            memcpy(&block_ok,block,size_ch);
-            struct memory_chunk_t *block_aligned = (struct memory_chunk_t*)((uint8_t*)ptr - size_ch - FENCE);
-
-            if(block->next == NULL){
-                if(block->size < size){
-                    size_t siz_need = size - block->size;
-                    siz_need = align_size(siz_need);
-
-                    void *ptr_sbrk = custom_sbrk(siz_need);
-                    if(ptr_sbrk == (void*)-1)
-                        return NULL;
-                    memory_manager.memory_size += siz_need;
-                }
-
-                memset((uint8_t*)block + size_ch + FENCE + block->size,'a', FENCE);
-                block->size = size;
-                block->free = 0;
-                memset((uint8_t*)block + size_ch + FENCE + size,'#', FENCE);
-
-                block->sum_control = 0;
-                block->sum_control = fun_sum_control(block);
-
-                memory_manager.memory_size += -size - 2*FENCE;
-                typ_pointer = get_pointer_type((uint8_t*)block + size_ch + FENCE);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)block + size_ch + FENCE;
-                return NULL;
-            }
+struct heap_arena_t
+{
+    struct region_chunk_t* first;
+    struct region_chunk_t* current;
+    uint8_t* top;
+    uint8_t* end;
+    size_t chunk_size;
+};
+
+static void region_enter(struct heap_arena_t* arena, struct region_chunk_t* chunk)
+{
+    arena->current = chunk;
+    arena->top = (uint8_t*)(chunk + 1);
+    arena->end = arena->top + chunk->size;
+}
 
-            if(size_free_L == size_ch + FENCE && size_free_R == size + FENCE){
-                memset((uint8_t*)block + size_ch + FENCE + block->size,'a', FENCE);
-                block->size = size;
-                block->free = 0;
+struct heap_arena_t* heap_arena_create(size_t chunk_size)
+{
+    if(chunk_size == 0)
+        chunk_size = HEAP_REGION_CHUNK;
+    if(chunk_size >= CHUNK_MAX_SPAN - sizeof(struct region_chunk_t)) return NULL;
 
-                memset((uint8_t*)block + size_ch + FENCE + size,'#', FENCE);
+    struct heap_arena_t *arena = heap_malloc(sizeof(struct heap_arena_t));
+    if(arena == NULL)
+        return NULL;
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->top = NULL;
+    arena->end = NULL;
+    arena->chunk_size = align16(chunk_size);
+    return arena;
+}
 
-                block->sum_control = 0;
-                block->sum_control = fun_sum_control(block);
+void* heap_arena_alloc(struct heap_arena_t* arena, size_t size)
+{
+    if(arena == NULL || size <= 0 || size >= CHUNK_MAX_SPAN) return NULL;
+    size = align16(size);
 
-                memory_manager.memory_size += -size - 2*FENCE;
-                typ_pointer = get_pointer_type((uint8_t*)block + size_ch + FENCE);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)block + size_ch + FENCE;
+    if(arena->top != NULL && size <= (size_t)(arena->end - arena->top)){
+        void *memblock = arena->top;
+        arena->top += size;
+        return memblock;
+    }
 
-                return NULL;
-            }
-            else {
-                if(size_free_L == size_ch + FENCE && myblock->size >= size){
-                    memory_manager.memory_size += myblock->size - size;
-                    memset((uint8_t*)block + size_ch + FENCE + block->size ,'a', FENCE);
-
-                    block->size = size;
-                    block->free = 0;
-                    memset((uint8_t*)block + size_ch,'#', FENCE);
-                    memset((uint8_t*)block + size_ch + FENCE + size ,'#', FENCE);
-                    block->sum_control = 0;
-                    block->sum_control = fun_sum_control(block);
-
-                    typ_pointer = get_pointer_type((uint8_t*)block + size_ch + FENCE);
-                    if(typ_pointer == pointer_valid)
-                        return (uint8_t*)block + size_ch + FENCE;
-                    return NULL;
-                }
-
-                block_aligned->size = size;
-                block_aligned->free = 0;
-                memset((uint8_t*)block_aligned + size_ch,'#', FENCE);
-                if(block == myblock && myblock->free == 0)
-                    memcpy((uint8_t*)block_aligned + size_ch + FENCE, (uint8_t*)myblock + size_ch + FENCE , block_ok.size);
-
-                if (size_L > 0) {
-                    if(block->prev && block->prev->free == 1){
-                        block->prev->size += size_L + size_ch;
-                        block_aligned->next = block->next;
-                        block->next->prev = block_aligned;
-
-                        block->prev->next = block_aligned;
-                        block_aligned->prev = block->prev;
-
-                        block->prev->sum_control = 0;
-                        block->prev->sum_control = fun_sum_control(block->prev);
-                        block_aligned->next->sum_control = 0;
-                        block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-
-                        memory_manager.memory_size += size_L + size_ch;
-
-                    }
-                    else {
-                        block->size = size_L;
-                        block->free = 1;
-                        block_aligned->next = block->next;
-                        block->next->prev = block_aligned;
-
-                        block_aligned->prev = block;
-                        block->next = block_aligned;
-
-                        block->sum_control = 0;
-                        block->sum_control = fun_sum_control(block);
-                        block_aligned->next->sum_control = 0;
-                        block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-                    }
-
-                }
-
-                if (free_R > 0 && block_ok.next && block_ok.next->free == 0) {
-                    struct memory_chunk_t *block_free_R = (struct memory_chunk_t *) ((uint8_t *) ptr + size +
-                                                                                     FENCE);
-                    block_free_R->size = free_R;
-                    block_free_R->free = 1;
-
-                    if (size_free_L == size_ch + FENCE) {
-                        block_free_R->next = block->next;
-                        block->next->prev = block_free_R;
-                        block_free_R->prev = block_aligned;
-                        block_aligned->next = block_free_R;
-
-                        block_free_R->sum_control = 0;
-                        block_free_R->sum_control = fun_sum_control(block_free_R);
-                        block_free_R->next->sum_control = 0;
-                        block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                    }
-                    if (size_L > 0) {
-                        block_free_R->next = block_aligned->next;
-                        block_aligned->next->prev = block_free_R;
-                        block_free_R->prev = block_aligned;
-                        block_aligned->next = block_free_R;
-
-                        block_free_R->sum_control = 0;
-                        block_free_R->sum_control = fun_sum_control(block_free_R);
-                        block_free_R->next->sum_control = 0;
-                        block_free_R->next->sum_control = fun_sum_control(block_free_R->next);
-                    }
-                    memory_manager.memory_size += -size_ch;
-                }
-                else if(free_R > 0 && block_ok.next && block_ok.next->free == 1 && block_ok.next->next)
-                {
-                    block_aligned->next = block_ok.next->next;
-                    block_ok.next->next->prev = block_aligned;
-
-                    block_aligned->next->sum_control = 0;
-                    block_aligned->next->sum_control = fun_sum_control(block_aligned->next);
-                }
-                memset((uint8_t*)block_aligned + size_ch + FENCE + size ,'#', FENCE);
-                block_aligned->free = 0;
-                block_aligned->sum_control = 0;
-                block_aligned->sum_control = fun_sum_control(block_aligned);
-
-                if(block_aligned != block)
-                    memory_manager.memory_size += -size_ch;
-                memory_manager.memory_size += - size - 2*FENCE;
-
-                if (block != myblock)
-                    heap_free((uint8_t*)myblock + size_ch + FENCE);
-
-                typ_pointer = get_pointer_type((uint8_t*)block_aligned + size_ch + FENCE);
-                if(typ_pointer == pointer_valid)
-                    return (uint8_t*)block_aligned + size_ch + FENCE;
-                return NULL;
-            }
+    // kawałki zostawione przez heap_arena_reset, potem nowy na końcu listy
+    struct region_chunk_t *chunk = arena->current;
+    while(chunk != NULL && chunk->next != NULL){
+        chunk = chunk->next;
+        if(chunk->size >= size){
+            region_enter(arena, chunk);
+            arena->top += size;
+            return chunk + 1;
         }
-        else{
-            struct memory_chunk_t *the_last_block = memory_manager.first_memory_chunk;
-            while (the_last_block->next) {
-                the_last_block = the_last_block->next;
-            }
+    }
 
-            size_t offset = (uint8_t *)the_last_block - (uint8_t *)memory_manager.memory_start;
-            offset = offset + the_last_block->size + size_ch;
-            if (the_last_block->free == 0)
-                offset = offset + 2*FENCE;
-
-            if ((align_size(offset) - offset < size_ch + FENCE))
-            {
-                void* ptr_sbrk = custom_sbrk(PAGE);
-                if(ptr_sbrk == (void*)-1)
-                    return NULL;
-                memory_manager.memory_size += PAGE;
-                offset =  offset + PAGE;
-            }
-            if (flag == 0)
-            {
-                size_t siz_need = size + size_ch + 2*FENCE;
-                siz_need = align_size(siz_need);
-
-                void *ptr_sbrk = custom_sbrk(siz_need);
-                if(ptr_sbrk == (void*)-1)
-                    return NULL;
-                memory_manager.memory_size += siz_need;
-            }
-            offset = align_size(offset);
-            offset += -size_ch - FENCE;
-
-            void* ptr_sbrk_last = custom_sbrk(0);
-            if((uint8_t*)memory_manager.memory_start + offset + size_ch + 2*FENCE + size >= (uint8_t*)ptr_sbrk_last)
-                return NULL;
-
-            struct memory_chunk_t* next_block = (struct memory_chunk_t*) ((uint8_t*)memory_manager.memory_start + offset);
-            memset((uint8_t*)next_block + size_ch,'#', FENCE);
-            memcpy((uint8_t*)next_block + size_ch + FENCE, (uint8_t*)myblock + size_ch + FENCE, myblock->size);
-            memset((uint8_t*)next_block + size_ch + size + FENCE,'#', FENCE);
-            heap_free((uint8_t*)myblock + size_ch + FENCE);
-
-            next_block->size = size;
-            next_block->free = 0;
-            next_block->next = NULL;
-            next_block->prev = the_last_block;
-            the_last_block->next = next_block;
-
-            next_block->sum_control = 0;
-            next_block->sum_control = fun_sum_control(next_block);
-            the_last_block->sum_control = 0;
-            the_last_block->sum_control = fun_sum_control(the_last_block);
-
-            memory_manager.memory_size += -size - size_ch - 2*FENCE;
-
-            typ_pointer = get_pointer_type((uint8_t*)next_block + size_ch + FENCE);
-            if(typ_pointer == pointer_valid)
-                return (uint8_t*)next_block + size_ch + FENCE;
-            return NULL;
-        }
+    size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+    struct region_chunk_t *new_chunk = heap_malloc(sizeof(struct region_chunk_t) + chunk_size);
+    if(new_chunk == NULL)
+        return NULL;
+    new_chunk->next = NULL;
+    new_chunk->size = chunk_size;
+    if(chunk != NULL)
+        chunk->next = new_chunk;
+    else
+        arena->first = new_chunk;
+    region_enter(arena, new_chunk);
+    arena->top += size;
+    return new_chunk + 1;
+}
+
+void heap_arena_reset(struct heap_arena_t* arena)
+{
+    if(arena == NULL || arena->first == NULL) return;
+    region_enter(arena, arena->first);
+}
+
+void heap_arena_destroy(struct heap_arena_t* arena)
+{
+    if(arena == NULL) return;
+    struct region_chunk_t *chunk = arena->first;
+    while(chunk != NULL){
+        struct region_chunk_t *next = chunk->next;
+        heap_free(chunk);
+        chunk = next;
     }
-    return NULL;
-}
\ No newline at end of file
+    heap_free(arena);
+}
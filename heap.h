@@ -1,24 +1,62 @@
 #if !defined(_HEAP_H_)
 #define _HEAP_H_
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HEAP_BIN_COUNT 128
+#define HEAP_MAX_ARENAS 8
+#define HEAP_SLAB_CLASSES 16
+
+struct slab_t;
+struct heap_page_t;
+struct heap_maxima_t;
+
 struct memory_manager_t
 {
     void *memory_start;
     size_t memory_size;
     struct memory_chunk_t *first_memory_chunk;
+    struct memory_chunk_t *last_memory_chunk;
+
+    struct memory_chunk_t *bins[HEAP_BIN_COUNT];
+    uint64_t bin_map[HEAP_BIN_COUNT / 64];
+    uint64_t sum_key;
+    size_t memory_reserved;     // 0 - pamięć z custom_sbrk, inaczej rozmiar rezerwacji mmap
+    size_t memory_zero;         // w arenie mmap pamięć od tego przesunięcia nie była jeszcze zapisana
+    size_t memory_step;         // ostatni przyrost sterty lub obszar, który go wymusił (najwyżej grow_max) - dolna granica progu oddawania
 
-} __attribute__(( packed ));
+    // strony slabów dla małych obiektów - osobna rezerwacja mmap
+    void *slab_start;
+    size_t slab_top;
+    struct slab_t *slabs[HEAP_SLAB_CLASSES];
+    struct slab_t *slab_empty;
 
-struct memory_manager_t memory_manager;
+    // mapa stron do klasyfikacji wskaźników w czasie stałym
+    struct heap_page_t *page_map;
+    // największe zajęte i wolne bloki, w tym samym mapowaniu co mapa stron
+    struct heap_maxima_t *maxima;
+    // rośnie, gdy znika początek bloku - unieważnia kursor heap_validate_step
+    uint64_t version;
+    // liczniki heap_get_stats: [0] zajęte bloki, [1] wolne bloki
+    size_t chunk_count[2];
+    size_t chunk_bytes[2];
+    size_t fence_bytes;
+    size_t slab_bytes;
+};
+
+// Główna arena; kolejne areny tworzone są dla wątków przy pierwszym użyciu
+extern struct memory_manager_t memory_manager;
 
+// Nagłówek bloku - 16 bajtów, dane zaczynają się za płotkiem na granicy 16 bajtów
 struct memory_chunk_t
 {
-    struct memory_chunk_t* prev;
-    struct memory_chunk_t* next;
-    size_t size;
-    int free;
+    uint32_t prev_size;
+    uint32_t span;      // wielokrotność 16, w najniższych bitach flagi
+    uint32_t size;
     int sum_control;
-} __attribute__(( packed ));
+};
 
 enum pointer_type_t
 {
@@ -31,8 +69,43 @@ enum pointer_type_t
     pointer_valid
 };
 
+// Poziom kontroli sterty wykonywanej przez funkcje alokujące
+enum heap_integrity_t
+{
+    heap_integrity_off,
+    heap_integrity_free,
+    heap_integrity_sampled,
+    heap_integrity_full
+};
+
+// Sposób wyszukiwania wolnych bloków; wybór obowiązuje od następnego heap_setup
+enum heap_engine_t
+{
+    heap_engine_default,    // najpierw dopasowanie w koszyku żądanego rozmiaru
+    heap_engine_tlsf        // TLSF - zawsze pierwszy blok z koszyka zaokrąglonego w górę, O(1)
+};
+
+enum heap_option_t
+{
+    heap_option_integrity,
+    heap_option_sample_period,
+    heap_option_tcache,
+    heap_option_arenas,
+    heap_option_slab,
+    heap_option_engine,
+    heap_option_mmap_threshold,    // bloki od tego rozmiaru dostają własne mapowanie, 0 wyłącza
+    heap_option_trim_threshold,    // wolny koniec sterty od tego rozmiaru (i od ostatniego przyrostu) plus trim_pad wraca do systemu przy zwolnieniu, 0 wyłącza
+    heap_option_trim_pad,          // zapas zostawiany za ostatnim blokiem przy oddawaniu pamięci
+    heap_option_grow_min,          // najmniejszy przyrost sterty przy braku miejsca
+    heap_option_grow_max,          // największy przyrost sterty; pomiędzy sterta rośnie o swój rozmiar
+    heap_option_histogram          // histogram rozmiarów przydziałów; co który przydział wątku jest próbką rozmiaru i czasu życia (okres zaokrąglany w górę do potęgi dwójki, 1 - histogram dokładny, od 4096 narzut poniżej 2%), 0 wyłącza
+};
+
+int heap_set_option(enum heap_option_t option, size_t value);
+
 int heap_setup(void);
 void heap_clean(void);
+int heap_trim(size_t pad);
 int fun_sum_control(const struct memory_chunk_t* block);
 int unused_size(void* memblock);
 
@@ -40,14 +113,77 @@ void* heap_malloc(size_t size);
 void* heap_calloc(size_t number, size_t size);
 void* heap_realloc(void* memblock, size_t size);
 void  heap_free(void* memblock);
+// Zwolnienie bloku o znanym rozmiarze bez klasyfikacji wskaźnika (poza pełną kontrolą integralności); rozmiar porównywany
+// z nagłówkiem bloku - niezgodny zostawia blok przydzielony i ustawia typ_pointer na pointer_heap_corrupted
+void  heap_free_sized(void* memblock, size_t size);
+
+// Przydział i zwolnienie wielu bloków pod jedną blokadą areny. heap_malloc_batch zwraca liczbę
+// przydzielonych bloków; heap_free_batch porządkuje tablicę ptrs według adresów.
+size_t heap_malloc_batch(size_t size, size_t count, void** out);
+void   heap_free_batch(void** ptrs, size_t count);
+
+// Stan sterty w bajtach; liczniki operacji od ostatniego heap_setup.
+// footprint = allocated + free + slack + metadata + fences
+struct heap_stats_t
+{
+    size_t allocated;       // dane zajętych bloków, obiektów slabów i dużych bloków
+    size_t free;            // pojemność wolnych bloków i niewykorzystany koniec sterty
+    size_t slack;           // wyrównanie, nieużywane miejsca w slabach i nadmiar stron dużych bloków
+    size_t metadata;        // nagłówki bloków, stron slabów i dużych bloków
+    size_t fences;          // płotki zajętych bloków
+    size_t footprint;       // pamięć pobrana z custom_sbrk i mmap
+    size_t brk;             // w tym z custom_sbrk
+    size_t chunks;          // bloki zajęte i wolne oraz duże bloki
+    uint64_t mallocs;
+    uint64_t frees;
+    uint64_t reallocs;
+};
+
+void heap_get_stats(struct heap_stats_t* stats);
+
+// Histogram od ostatniego heap_setup: rozmiary przydziałów (szacowane z próbek) w przedziałach od heap_histogram_bucket_size(i)
+// do heap_histogram_bucket_size(i + 1), próbkowane czasy życia w przedziałach [2^i, 2^(i+1)) ns
+#define HEAP_LIFETIME_BUCKETS 48
+
+struct heap_histogram_t
+{
+    uint64_t sizes[HEAP_BIN_COUNT];
+    uint64_t lifetimes[HEAP_LIFETIME_BUCKETS];
+};
+
+void   heap_get_histogram(struct heap_histogram_t* histogram);
+size_t heap_histogram_bucket_size(int bucket);
+void   heap_histogram_dump(FILE* stream);
 
 size_t   heap_get_largest_used_block_size(void);
+// Największy obszar, który można przydzielić z jednego wolnego bloku lub wolnego końca sterty bez powiększania sterty
+size_t   heap_get_largest_free_block_size(void);
 enum pointer_type_t get_pointer_type(const void* const pointer);
-enum pointer_type_t typ_pointer;
+extern _Thread_local enum pointer_type_t typ_pointer;
 int heap_validate(void);
+// Walidacja po kawałku: co najwyżej budget bloków od miejsca, w którym skończyło poprzednie wywołanie.
+// Zwraca kod błędu jak heap_validate, 0 po zakończeniu pełnego przejścia, -1 gdy przejście trwa.
+int heap_validate_step(size_t budget);
+// Walidacja w tle: wątek co period_ms wywołuje heap_validate_step(budget) i zapamiętuje pierwszy błąd.
+// heap_validate_background_stop zatrzymuje wątek i zwraca zapamiętany błąd (0 - brak).
+int heap_validate_background_start(size_t budget, unsigned period_ms);
+int heap_validate_background_status(void);
+int heap_validate_background_stop(void);
 
 void* heap_malloc_aligned(size_t count);
 void* heap_calloc_aligned(size_t number, size_t size_of);
 void* heap_realloc_aligned(void* memblock, size_t size);
+// Dowolne wyrównanie będące potęgą dwójki; NULL dla innych wartości
+void* heap_memalign(size_t alignment, size_t size);
+void* heap_aligned_alloc(size_t alignment, size_t size);
+
+// Region: obiekty przydzielane przesunięciem wskaźnika i zwalniane wszystkie naraz.
+// Pamięć pochodzi ze sterty; jednego regionu nie należy używać z kilku wątków jednocześnie.
+struct heap_arena_t;
+
+struct heap_arena_t* heap_arena_create(size_t chunk_size);
+void* heap_arena_alloc(struct heap_arena_t* arena, size_t size);
+void  heap_arena_reset(struct heap_arena_t* arena);
+void  heap_arena_destroy(struct heap_arena_t* arena);
 
 #endif // _HEAP_H
\ No newline at end of file
@@ -1,6 +1,95 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "heap.h"
+
+// Pomiar opóźnień heap_malloc dla obu silników przy rosnącej liczbie zajętych bloków
+#define BENCH_SLOTS 16384
+#define BENCH_OPS 20000
+
+static void *slots[BENCH_SLOTS];
+static uint32_t samples[BENCH_OPS];
+static uint64_t bench_seed = 0x9E3779B97F4A7C15ULL;
+
+static uint32_t bench_random(void)
+{
+    bench_seed ^= bench_seed << 13;
+    bench_seed ^= bench_seed >> 7;
+    bench_seed ^= bench_seed << 17;
+    return (uint32_t)bench_seed;
+}
+
+// przewaga małych bloków, co setny większy niż strona
+static size_t bench_size(void)
+{
+    uint32_t r = bench_random() % 100;
+    if(r < 75)
+        return 16 + bench_random() % 496;
+    if(r < 99)
+        return 512 + bench_random() % 3584;
+    return 4096 + bench_random() % 28672;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_samples(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int bench_run(enum heap_engine_t engine, int live)
+{
+    heap_set_option(heap_option_engine, engine);
+    if(heap_setup() != 0)
+        return -1;
+    heap_set_option(heap_option_integrity, heap_integrity_off);
+    heap_set_option(heap_option_tcache, 0);
+    heap_set_option(heap_option_slab, 0);
+
+    // sterta z dziurami: wszystkie miejsca zajęte, potem połowa zwolniona
+    for(int i = 0; i < live; i++)
+        slots[i] = heap_malloc(bench_size());
+    for(int i = 0; i < live; i += 2){
+        heap_free(slots[i]);
+        slots[i] = NULL;
+    }
+
+    for(int op = 0; op < BENCH_OPS; op++){
+        int i = (int)(bench_random() % (uint32_t)live);
+        heap_free(slots[i]);
+        size_t size = bench_size();
+        uint64_t start = now_ns();
+        slots[i] = heap_malloc(size);
+        samples[op] = (uint32_t)(now_ns() - start);
+    }
+
+    for(int i = 0; i < live; i++){
+        heap_free(slots[i]);
+        slots[i] = NULL;
+    }
+    heap_clean();
+
+    qsort(samples, BENCH_OPS, sizeof(samples[0]), compare_samples);
+    printf("%-8s %7d %10u %10u %10u\n", engine == heap_engine_tlsf ? "tlsf" : "default", live,
+           samples[BENCH_OPS / 2], samples[BENCH_OPS - BENCH_OPS / 1000], samples[BENCH_OPS - 1]);
+    return 0;
+}
 
 int main() {
-    printf("Hello, World!\n");
+    printf("%-8s %7s %10s %10s %10s\n", "silnik", "bloki", "p50 [ns]", "p99.9 [ns]", "max [ns]");
+    for(int engine = heap_engine_default; engine <= heap_engine_tlsf; engine++)
+        for(int live = 1024; live <= BENCH_SLOTS; live *= 4)
+            if(bench_run((enum heap_engine_t)engine, live) != 0){
+                printf("heap_setup nie powiódł się\n");
+                return 1;
+            }
+    heap_set_option(heap_option_engine, heap_engine_default);
     return 0;
 }
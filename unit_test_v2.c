@@ -17,6 +17,8 @@
 #include <signal.h>
 #include <setjmp.h>
 #include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
 
 #if !defined(__clang__) && !defined(__GNUC__)
 // Zakomentuj poniższy błąd, jeżeli chcesz przetestować testy na swoim kompilatorze C.
@@ -8434,6 +8436,2817 @@ void UTEST133(void)
     test_ok();
 }
 
+//
+//  Test 134: Sprawdzanie poprawności działania funkcji heap_set_option - test sprawdza poprawność działania funkcji alokujących przy obniżonym poziomie kontroli sterty
+//
+void UTEST134(void)
+{
+    // informacje o teście
+    test_start(134, "Sprawdzanie poprawności działania funkcji heap_set_option - test sprawdza poprawność działania funkcji alokujących przy obniżonym poziomie kontroli sterty", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_integrity, 4);
+                test_error(status == -1, "Funkcja heap_set_option() powinna zwrócić wartość -1, a zwróciła na %d", status);
+
+                enum heap_integrity_t levels[] = { heap_integrity_off, heap_integrity_free, heap_integrity_sampled };
+                for (int i = 0; i < 3; ++i)
+                {
+                    status = heap_set_option(heap_option_integrity, levels[i]);
+                    test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                    char *ptr1 = heap_malloc(120);
+                    char *ptr2 = heap_calloc(30, 4);
+                    test_error(ptr1 != NULL && ptr2 != NULL, "Funkcja heap_malloc() i heap_calloc() powinny przydzielić pamięć");
+
+                    ptr1 = heap_realloc(ptr1, 400);
+                    test_error(ptr1 != NULL, "Funkcja heap_realloc() powinna przydzielić pamięć");
+                    test_error(get_pointer_type(ptr1) == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić pointer_valid");
+
+                    heap_free(ptr1);
+                    heap_free(ptr2);
+                    test_error(get_pointer_type(ptr2) == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić pointer_unallocated");
+
+                    status = heap_validate();
+                    test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                }
+
+                status = heap_set_option(heap_option_integrity, heap_integrity_full);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 135: Sprawdzanie poprawności działania funkcji heap_malloc i heap_free z pamięcią podręczną wątku
+//
+void UTEST135(void)
+{
+    // informacje o teście
+    test_start(135, "Sprawdzanie poprawności działania funkcji heap_malloc i heap_free z pamięcią podręczną wątku", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_tcache, 4);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(40);
+                test_error(ptr1 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(((intptr_t)ptr1 & 15) == 0, "Funkcja heap_malloc() powinna zwrócić adres wyrównany do 16 bajtów");
+
+                heap_free(ptr1);
+                char *ptr2 = heap_malloc(35);
+                test_error(ptr1 == ptr2, "Funkcja heap_malloc() powinna zwrócić blok z pamięci podręcznej wątku");
+
+                for (int i = 0; i < 40; ++i)
+                    ptr2[i] = (char)i;
+                heap_free(ptr2);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_tcache, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 136: Sprawdzanie poprawności działania funkcji heap_set_option dla liczby aren
+//
+void UTEST136(void)
+{
+    // informacje o teście
+    test_start(136, "Sprawdzanie poprawności działania funkcji heap_set_option dla liczby aren", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, 0);
+                test_error(status == -1, "Funkcja heap_set_option() powinna zwrócić wartość -1, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, HEAP_MAX_ARENAS + 1);
+                test_error(status == -1, "Funkcja heap_set_option() powinna zwrócić wartość -1, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, HEAP_MAX_ARENAS);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr = heap_malloc(120);
+                test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                status = get_pointer_type(ptr);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                heap_free(ptr);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 137: Sprawdzanie poprawności działania slabów dla małych obiektów
+//
+void UTEST137(void)
+{
+    // informacje o teście
+    test_start(137, "Sprawdzanie poprawności działania slabów dla małych obiektów", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_slab, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(24);
+                char *ptr2 = heap_malloc(30);
+                test_error(ptr1 != NULL && ptr2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(ptr2 == ptr1 + 32, "Obiekty jednej klasy powinny leżeć w slabie jeden za drugim");
+
+                status = get_pointer_type(ptr1);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                status = get_pointer_type(ptr1 + 5);
+                test_error(status == pointer_inside_data_block, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_inside_data_block, a zwróciła na %d", status);
+
+                heap_free(ptr1);
+
+                status = get_pointer_type(ptr1);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 32, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 32, a zwróciła na %zu", largest);
+
+                heap_free(ptr2);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_slab, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 138: Sprawdzanie poprawności działania regionów heap_arena_create, heap_arena_alloc, heap_arena_reset i heap_arena_destroy
+//
+void UTEST138(void)
+{
+    // informacje o teście
+    test_start(138, "Sprawdzanie poprawności działania regionów heap_arena_create, heap_arena_alloc, heap_arena_reset i heap_arena_destroy", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                struct heap_arena_t *arena = heap_arena_create(1024);
+                test_error(arena != NULL, "Funkcja heap_arena_create() powinna zwrócić adres regionu, a zwróciła NULL");
+
+                char *ptr1 = heap_arena_alloc(arena, 24);
+                char *ptr2 = heap_arena_alloc(arena, 8);
+                test_error(ptr1 != NULL && ptr2 != NULL, "Funkcja heap_arena_alloc() powinna zwrócić adres przydzielonej pamięci, a zwróciła NULL");
+                test_error(((intptr_t)ptr1 & 15) == 0 && ptr2 == ptr1 + 32, "Funkcja heap_arena_alloc() powinna przydzielać kolejne obiekty wyrównane do 16 bajtów jeden za drugim");
+
+                for (int i = 0; i < 200; ++i) {
+                    char *ptr = heap_arena_alloc(arena, 40);
+                    test_error(ptr != NULL, "Funkcja heap_arena_alloc() powinna zwrócić adres przydzielonej pamięci, a zwróciła NULL");
+                    memset(ptr, i, 40);
+                }
+
+                char *big = heap_arena_alloc(arena, 5000);
+                test_error(big != NULL, "Funkcja heap_arena_alloc() powinna zwrócić adres przydzielonej pamięci, a zwróciła NULL");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_arena_reset(arena);
+                char *ptr3 = heap_arena_alloc(arena, 24);
+                test_error(ptr3 == ptr1, "Po wywołaniu heap_arena_reset() region powinien przydzielać pamięć od początku");
+
+                heap_arena_destroy(arena);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 139: Sprawdzanie poprawności działania silnika TLSF
+//
+void UTEST139(void)
+{
+    // informacje o teście
+    test_start(139, "Sprawdzanie poprawności działania silnika TLSF", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_set_option(heap_option_engine, heap_engine_tlsf + 1);
+                test_error(status == -1, "Funkcja heap_set_option() powinna zwrócić wartość -1, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_engine, heap_engine_tlsf);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(1000);
+                char *ptr2 = heap_malloc(100);
+                test_error(ptr1 != NULL && ptr2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_free(ptr1);
+                char *ptr3 = heap_malloc(200);
+                test_error(ptr3 == ptr1, "Funkcja heap_malloc() powinna zwrócić blok z koszyka wolnych bloków");
+
+                char *ptr4 = heap_malloc_aligned(300);
+                test_error(ptr4 != NULL && ((intptr_t)ptr4 & 4095) == 0, "Funkcja heap_malloc_aligned() powinna zwrócić adres wyrównany do strony");
+
+                heap_free(ptr2);
+                heap_free(ptr3);
+                heap_free(ptr4);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+                 heap_set_option(heap_option_engine, heap_engine_default);
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 140: Sprawdzanie poprawności działania dużych bloków w osobnych mapowaniach
+//
+void UTEST140(void)
+{
+    // informacje o teście
+    test_start(140, "Sprawdzanie poprawności działania dużych bloków w osobnych mapowaniach", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_mmap_threshold, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *small = heap_malloc(100);
+                char *ptr = heap_malloc(1000000);
+                test_error(small != NULL && ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory < 1000000, "Duży blok nie powinien powiększać sterty, a zarezerwowano %llu bajtów", reserved_memory);
+
+                status = get_pointer_type(ptr);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                status = get_pointer_type(ptr - 1);
+                test_error(status == pointer_inside_fences, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_inside_fences, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 1000000, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 1000000, a zwróciła na %zu", largest);
+
+                memset(ptr, 'x', 1000000);
+                ptr = heap_realloc(ptr, 3000000);
+                test_error(ptr != NULL && ptr[999999] == 'x', "Funkcja heap_realloc() powinna zachować zawartość dużego bloku");
+
+                ptr[3000000] = 0;
+                status = heap_validate();
+                test_error(status == 1, "Funkcja heap_validate() powinna zwrócić wartość 1, a zwróciła na %d", status);
+                ptr[3000000] = '#';
+
+                heap_free(ptr);
+                heap_free(small);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_set_option(heap_option_mmap_threshold, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 141: Sprawdzanie poprawności oddawania wolnego końca sterty
+//
+void UTEST141(void)
+{
+    // informacje o teście
+    test_start(141, "Sprawdzanie poprawności oddawania wolnego końca sterty", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_trim_threshold, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_trim_pad, 4096);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *small = heap_malloc(100);
+                char *ptr = heap_malloc(1000000);
+                char *ptr2 = heap_malloc(1000000);
+                test_error(small != NULL && ptr != NULL && ptr2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory >= 2000000, "Sterta powinna mieć co najmniej 2000000 bajtów, a ma %llu", reserved_memory);
+
+                heap_free(ptr2);
+                heap_free(ptr);
+
+                // koniec sterty oddany po pierwszym zwolnieniu; drugi blok (1 MB) nie przekracza progu ostatniego przyrostu
+                reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory <= 1048576 + 16384, "Po zwolnieniu ostatnich bloków sterta powinna zostać zmniejszona do ostatniego przyrostu, a ma %llu bajtów", reserved_memory);
+
+                status = heap_set_option(heap_option_trim_threshold, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                ptr = heap_malloc(1000000);
+                test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                heap_free(ptr);
+
+                reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory >= 1000000, "Przy wyłączonym progu sterta nie powinna się zmniejszać, a ma %llu bajtów", reserved_memory);
+
+                status = heap_trim(0);
+                test_error(status == 1, "Funkcja heap_trim() powinna zwrócić wartość 1, a zwróciła na %d", status);
+
+                reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory <= 8192, "Funkcja heap_trim() powinna oddać wolny koniec sterty, a zostało %llu bajtów", reserved_memory);
+
+                status = heap_trim(0);
+                test_error(status == 0, "Funkcja heap_trim() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(small);
+
+                status = heap_set_option(heap_option_trim_threshold, 131072);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_trim_pad, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 142: Sprawdzanie poprawności geometrycznego powiększania sterty
+//
+void UTEST142(void)
+{
+    // informacje o teście
+    test_start(142, "Sprawdzanie poprawności geometrycznego powiększania sterty", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_grow_min, 1048576);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(10000);
+                test_error(ptr1 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory >= 1048576, "Sterta powinna urosnąć o co najmniej 1048576 bajtów, a ma %llu", reserved_memory);
+
+                char *ptr2 = heap_malloc(500000);
+                test_error(ptr2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                test_error(reserved_after == reserved_memory, "Blok mieszczący się w zapasie nie powinien powiększać sterty, a zarezerwowano %llu zamiast %llu bajtów", reserved_after, reserved_memory);
+
+                status = heap_set_option(heap_option_grow_min, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_grow_max, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr4 = heap_malloc(2097152);
+                test_error(ptr4 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory - reserved_after < 2097152 + 8192, "Bez zapasu sterta powinna urosnąć tylko o brakującą część, a urosła o %llu bajtów", reserved_memory - reserved_after);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(ptr1);
+                heap_free(ptr2);
+                heap_free(ptr4);
+
+                status = heap_set_option(heap_option_grow_min, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_grow_max, 1048576);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 143: Sprawdzanie poprawności zmiany rozmiaru bloku w miejscu
+//
+void UTEST143(void)
+{
+    // informacje o teście
+    test_start(143, "Sprawdzanie poprawności zmiany rozmiaru bloku w miejscu", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(200);
+                char *ptr2 = heap_malloc(100);
+                char *ptr3 = heap_malloc(100);
+                test_error(ptr1 != NULL && ptr2 != NULL && ptr3 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                for (int i = 0; i < 100; ++i)
+                    ptr2[i] = (char)i;
+
+                heap_free(ptr1);
+
+                char *ptr = heap_realloc(ptr2, 250);
+                test_error(ptr == ptr1, "Funkcja heap_realloc() powinna powiększyć blok kosztem wolnego poprzednika");
+
+                int same = 1;
+                for (int i = 0; i < 100; ++i)
+                    same = same && ptr[i] == (char)i;
+                test_error(same, "Funkcja heap_realloc() powinna zachować zawartość bloku");
+
+                status = get_pointer_type(ptr);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *big = heap_malloc(2000);
+                char *guard = heap_malloc(100);
+                test_error(big != NULL && guard != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                char *small = heap_realloc(big, 100);
+                test_error(small == big, "Funkcja heap_realloc() powinna zwrócić ten sam adres, który został do niej przekazany");
+
+                char *reused = heap_malloc(1000);
+                test_error(reused > big && reused < big + 2000, "Zwolniona końcówka zmniejszonego bloku powinna zostać ponownie użyta");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(reused);
+                heap_free(small);
+                heap_free(guard);
+                heap_free(ptr);
+                heap_free(ptr3);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 144: Sprawdzanie poprawności działania funkcji heap_memalign dla różnych wyrównań
+//
+void UTEST144(void)
+{
+    // informacje o teście
+    test_start(144, "Sprawdzanie poprawności działania funkcji heap_memalign dla różnych wyrównań", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t alignments[] = {32, 64, 8192, 2097152};
+                char *ptrs[4];
+                for (int i = 0; i < 4; ++i) {
+                    ptrs[i] = heap_memalign(alignments[i], 1000 + i);
+                    test_error(ptrs[i] != NULL, "Funkcja heap_memalign() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                    test_error(((intptr_t)ptrs[i] & (intptr_t)(alignments[i] - 1)) == 0, "Funkcja heap_memalign() powinna zwrócić adres wyrównany do %zu bajtów", alignments[i]);
+                    status = get_pointer_type(ptrs[i]);
+                    test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+                    memset(ptrs[i], 'a' + i, 1000 + i);
+                }
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                test_error(heap_memalign(48, 100) == NULL, "Funkcja heap_memalign() powinna zwrócić NULL dla wyrównania, które nie jest potęgą dwójki");
+                test_error(heap_memalign(0, 100) == NULL, "Funkcja heap_memalign() powinna zwrócić NULL dla wyrównania równego 0");
+
+                char *ptr = heap_aligned_alloc(8, 100);
+                test_error(ptr != NULL && get_pointer_type(ptr) == pointer_valid, "Funkcja heap_aligned_alloc() powinna zwrócić adres przydzielonego bloku pamięci");
+
+                // zwolniony blok wyrównany do 2 MB wraca pod ten sam adres
+                heap_free(ptrs[3]);
+                char *reuse = heap_memalign(2097152, 1003);
+                test_error(reuse == ptrs[3], "Funkcja heap_memalign() powinna ponownie użyć zwolnionej przestrzeni");
+                ptrs[3] = reuse;
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(ptr);
+                for (int i = 0; i < 4; ++i)
+                    heap_free(ptrs[i]);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 145: Sprawdzanie poprawności działania funkcji heap_calloc dla nowej i ponownie używanej pamięci
+//
+void UTEST145(void)
+{
+    // informacje o teście
+    test_start(145, "Sprawdzanie poprawności działania funkcji heap_calloc dla nowej i ponownie używanej pamięci", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                void *ptr = heap_calloc(SIZE_MAX / 2, 4);
+                test_error(ptr == NULL, "Funkcja heap_calloc() powinna zwrócić NULL, gdy iloczyn argumentów przekracza zakres size_t");
+
+                ptr = heap_calloc_aligned(4, SIZE_MAX / 2);
+                test_error(ptr == NULL, "Funkcja heap_calloc_aligned() powinna zwrócić NULL, gdy iloczyn argumentów przekracza zakres size_t");
+
+                char *dirty = heap_malloc(1000);
+                test_error(dirty != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                memset(dirty, 'x', 1000);
+                heap_free(dirty);
+
+                unsigned char *ptr1 = heap_calloc(10, 100);
+                test_error(ptr1 != NULL, "Funkcja heap_calloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                int zero = 1;
+                for (int i = 0; i < 1000; ++i)
+                    zero = zero && ptr1[i] == 0;
+                test_error(zero, "Funkcja heap_calloc() powinna wyzerować ponownie używaną pamięć");
+
+                status = heap_set_option(heap_option_mmap_threshold, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                unsigned char *ptr2 = heap_calloc(1000, 1000);
+                test_error(ptr2 != NULL, "Funkcja heap_calloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                zero = 1;
+                for (int i = 0; i < 1000000; ++i)
+                    zero = zero && ptr2[i] == 0;
+                test_error(zero, "Funkcja heap_calloc() powinna zwrócić wyzerowaną pamięć");
+
+                status = get_pointer_type(ptr2);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                heap_free(ptr2);
+                heap_free(ptr1);
+
+                status = heap_set_option(heap_option_mmap_threshold, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 146: Sprawdzanie poprawności przydzielania i zwalniania bloków seriami
+//
+void UTEST146(void)
+{
+    // informacje o teście
+    test_start(146, "Sprawdzanie poprawności przydzielania i zwalniania bloków seriami", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                void *ptrs[100];
+                size_t count = heap_malloc_batch(48, 100, ptrs);
+                test_error(count == 100, "Funkcja heap_malloc_batch() powinna przydzielić 100 bloków, a przydzieliła %zu", count);
+
+                intptr_t stride = (char*)ptrs[1] - (char*)ptrs[0];
+                int contiguous = stride > 48;
+                for (int i = 0; i < 100; ++i) {
+                    status = get_pointer_type(ptrs[i]);
+                    test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+                    if (i > 0)
+                        contiguous = contiguous && (char*)ptrs[i] - (char*)ptrs[i - 1] == stride;
+                    memset(ptrs[i], i, 48);
+                }
+                test_error(contiguous, "Bloki z heap_malloc_batch() powinny leżeć w jednym ciągłym obszarze");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                void *first = ptrs[0];
+                for (int i = 0; i < 50; ++i) {
+                    void *temp = ptrs[i];
+                    ptrs[i] = ptrs[99 - i];
+                    ptrs[99 - i] = temp;
+                }
+                heap_free_batch(ptrs, 100);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                count = heap_malloc_batch(48, 100, ptrs);
+                test_error(count == 100 && ptrs[0] == first, "Funkcja heap_malloc_batch() powinna ponownie użyć zwolnionego obszaru");
+
+                count = heap_malloc_batch(0, 10, ptrs + 50);
+                test_error(count == 0, "Funkcja heap_malloc_batch() powinna zwrócić 0 dla rozmiaru 0, a zwróciła %zu", count);
+
+                heap_free_batch(ptrs, 100);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 147: Sprawdzanie poprawności działania funkcji heap_free_sized
+//
+void UTEST147(void)
+{
+    // informacje o teście
+    test_start(147, "Sprawdzanie poprawności działania funkcji heap_free_sized", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr1 = heap_malloc(100);
+                char *ptr2 = heap_malloc(200);
+                char *ptr3 = heap_malloc(300);
+                test_error(ptr1 != NULL && ptr2 != NULL && ptr3 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_free_sized(ptr2, 200);
+                status = get_pointer_type(ptr2);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr4 = heap_realloc(ptr3, 500);
+                test_error(ptr4 != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_free_sized(ptr4, 500);
+                heap_free_sized(ptr1, 100);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_set_option(heap_option_mmap_threshold, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr5 = heap_malloc(100000);
+                test_error(ptr5 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_free_sized(ptr5, 100000);
+                status = get_pointer_type(ptr5);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_mmap_threshold, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free_sized(NULL, 100);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 148: Sprawdzanie poprawności klasyfikacji wskaźników przez mapę stron
+//
+void UTEST148(void)
+{
+    // informacje o teście
+    test_start(148, "Sprawdzanie poprawności klasyfikacji wskaźników przez mapę stron", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptrs[200];
+                for (int i = 0; i < 200; ++i) {
+                    ptrs[i] = heap_malloc(20 + i * 7);
+                    test_error(ptrs[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                }
+                char *big = heap_malloc(50000);
+                test_error(big != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                for (int i = 0; i < 200; i += 3)
+                    heap_free(ptrs[i]);
+
+                int ok = 1;
+                for (int i = 0; i < 200 && ok; ++i) {
+                    size_t size = 20 + i * 7;
+                    if (i % 3 == 0) {
+                        ok = get_pointer_type(ptrs[i]) == pointer_unallocated && get_pointer_type(ptrs[i] + size / 2) == pointer_unallocated;
+                        continue;
+                    }
+                    ok = get_pointer_type(ptrs[i]) == pointer_valid
+                        && get_pointer_type(ptrs[i] + 1) == pointer_inside_data_block
+                        && get_pointer_type(ptrs[i] + size - 1) == pointer_inside_data_block
+                        && get_pointer_type(ptrs[i] - 1) == pointer_inside_fences
+                        && get_pointer_type(ptrs[i] + size) == pointer_inside_fences
+                        && get_pointer_type(ptrs[i] - 17) == pointer_control_block;
+                }
+                test_error(ok, "Funkcja get_pointer_type() powinna poprawnie klasyfikować wskaźniki w wielu blokach");
+
+                status = get_pointer_type(big + 30000);
+                test_error(status == pointer_inside_data_block, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_inside_data_block, a zwróciła na %d", status);
+
+                big = heap_realloc(big, 1000);
+                test_error(big != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                status = get_pointer_type(big + 30000);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                status = get_pointer_type(big + 999);
+                test_error(status == pointer_inside_data_block, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_inside_data_block, a zwróciła na %d", status);
+
+                heap_free(big);
+                for (int i = 0; i < 200; ++i)
+                    if (i % 3 != 0)
+                        heap_free(ptrs[i]);
+
+                status = get_pointer_type(ptrs[1]);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 149: Sprawdzanie funkcji heap_validate_step() i walidacji w tle
+//
+void UTEST149(void)
+{
+    // informacje o teście
+    test_start(149, "Sprawdzanie funkcji heap_validate_step() i walidacji w tle", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptrs[100];
+                for (int i = 0; i < 100; ++i) {
+                    ptrs[i] = heap_malloc(1000 + i * 10);
+                    test_error(ptrs[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                }
+
+                int steps = 0;
+                while ((status = heap_validate_step(8)) == -1)
+                    steps++;
+                test_error(status == 0, "Funkcja heap_validate_step() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                test_error(steps >= 10, "Funkcja heap_validate_step() powinna sprawdzać co najwyżej 8 bloków w jednym wywołaniu");
+
+                // zmiany sterty pomiędzy krokami nie przerywają przejścia
+                for (int i = 0; i < 3; ++i) {
+                    status = heap_validate_step(8);
+                    test_error(status == -1, "Funkcja heap_validate_step() powinna zwrócić wartość -1, a zwróciła na %d", status);
+                }
+                for (int i = 0; i < 100; i += 2) {
+                    heap_free(ptrs[i]);
+                    ptrs[i] = NULL;
+                }
+                while ((status = heap_validate_step(8)) == -1)
+                    ;
+                test_error(status == 0, "Funkcja heap_validate_step() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                ptrs[91][-1] = 'x';
+                while ((status = heap_validate_step(8)) == -1)
+                    ;
+                test_error(status == 1, "Funkcja heap_validate_step() powinna zwrócić wartość 1, a zwróciła na %d", status);
+                ptrs[91][-1] = '#';
+
+                status = heap_validate_background_start(16, 1);
+                test_error(status == 0, "Funkcja heap_validate_background_start() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                ptrs[91][1000 + 91 * 10] = 'x';
+                for (int i = 0; i < 2000 && heap_validate_background_status() == 0; ++i)
+                    for (volatile int k = 0; k < 100000; ++k)
+                        ;
+                status = heap_validate_background_stop();
+                test_error(status == 1, "Funkcja heap_validate_background_stop() powinna zwrócić wartość 1, a zwróciła na %d", status);
+                ptrs[91][1000 + 91 * 10] = '#';
+
+                for (int i = 1; i < 100; i += 2)
+                    heap_free(ptrs[i]);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 150: Sprawdzanie funkcji heap_get_largest_used_block_size() i heap_get_largest_free_block_size()
+//
+void UTEST150(void)
+{
+    // informacje o teście
+    test_start(150, "Sprawdzanie funkcji heap_get_largest_used_block_size() i heap_get_largest_free_block_size()", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // pusta sterta to sam wolny koniec, a rośnie tylko o brakujące strony - wolny koniec jest mniejszy niż strona
+                size_t block_size = heap_get_largest_free_block_size();
+                test_error(block_size < 4096, "Funkcja heap_get_largest_free_block_size() powinna zwrócić tylko pojemność wolnego końca sterty, a zwróciła na %lu", block_size);
+
+                status = heap_set_option(heap_option_grow_min, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_grow_max, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *p1 = heap_malloc(5000);
+                char *p2 = heap_malloc(300);
+                char *p3 = heap_malloc(20000);
+                char *p4 = heap_malloc(700);
+                test_error(p1 != NULL && p2 != NULL && p3 != NULL && p4 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 20000, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 20000, a zwróciła na %lu", block_size);
+
+                heap_free(p3);
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 5000, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 5000, a zwróciła na %lu", block_size);
+                block_size = heap_get_largest_free_block_size();
+                test_error(block_size == 20000, "Funkcja heap_get_largest_free_block_size() powinna zwrócić wartość 20000, a zwróciła na %lu", block_size);
+
+                heap_free(p1);
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 700, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 700, a zwróciła na %lu", block_size);
+
+                // po zwolnieniu p2 trzy wolne bloki łączą się w jeden
+                heap_free(p2);
+                block_size = heap_get_largest_free_block_size();
+                test_error(block_size > 25000, "Funkcja heap_get_largest_free_block_size() powinna zwrócić wartość większą niż 25000, a zwróciła na %lu", block_size);
+                size_t free_size = block_size;
+                char *p5 = heap_malloc(free_size);
+                test_error(p5 == p1, "Funkcja heap_malloc() powinna przydzielić blok w miejscu największego wolnego bloku");
+                block_size = heap_get_largest_free_block_size();
+                test_error(block_size < 4096, "Funkcja heap_get_largest_free_block_size() powinna zwrócić tylko pojemność wolnego końca sterty, a zwróciła na %lu", block_size);
+
+                char *large1 = heap_malloc(2 * 1024 * 1024);
+                char *large2 = heap_malloc(3 * 1024 * 1024);
+                test_error(large1 != NULL && large2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 3 * 1024 * 1024, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość %lu, a zwróciła na %lu", (size_t)3 * 1024 * 1024, block_size);
+
+                large1 = heap_realloc(large1, 4 * 1024 * 1024);
+                test_error(large1 != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 4 * 1024 * 1024, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość %lu, a zwróciła na %lu", (size_t)4 * 1024 * 1024, block_size);
+
+                heap_free(large1);
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 3 * 1024 * 1024, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość %lu, a zwróciła na %lu", (size_t)3 * 1024 * 1024, block_size);
+                heap_free(large2);
+
+                // bez pełnej kontroli integralności odczyt nie sprawdza sterty
+                heap_set_option(heap_option_integrity, heap_integrity_free);
+                p4[-1] = 'x';
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == free_size && heap_validate() == 1, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość %lu, a zwróciła na %lu", free_size, block_size);
+                p4[-1] = '#';
+                heap_set_option(heap_option_integrity, heap_integrity_full);
+
+                heap_free(p4);
+                heap_free(p5);
+                block_size = heap_get_largest_used_block_size();
+                test_error(block_size == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %lu", block_size);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_grow_min, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_grow_max, 1048576);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 151: Sprawdzanie funkcji heap_get_stats()
+//
+void UTEST151(void)
+{
+    // informacje o teście
+    test_start(151, "Sprawdzanie funkcji heap_get_stats()", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                struct heap_stats_t stats;
+                heap_get_stats(&stats);
+                test_error(stats.allocated == 0 && stats.chunks == 0 && stats.mallocs == 0 && stats.frees == 0, "Funkcja heap_get_stats() powinna zwrócić zerowe liczniki po heap_setup()");
+                test_error(stats.brk == custom_sbrk_get_reserved_memory(), "Funkcja heap_get_stats() powinna zwrócić brk równe %llu, a zwróciła %lu", custom_sbrk_get_reserved_memory(), stats.brk);
+
+                char *p1 = heap_malloc(300);
+                char *p2 = heap_malloc(1000);
+                char *p3 = heap_calloc(5, 1000);
+                test_error(p1 != NULL && p2 != NULL && p3 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_get_stats(&stats);
+                test_error(stats.allocated == 6300, "Funkcja heap_get_stats() powinna zwrócić allocated równe 6300, a zwróciła %lu", stats.allocated);
+                test_error(stats.chunks == 3 && stats.mallocs == 3, "Funkcja heap_get_stats() powinna zwrócić 3 bloki i 3 przydziały, a zwróciła %lu i %lu", stats.chunks, (size_t)stats.mallocs);
+                test_error(stats.fences == 3 * 32 + 4 + 8 + 8, "Funkcja heap_get_stats() powinna zwrócić fences równe 116, a zwróciła %lu", stats.fences);
+                test_error(stats.allocated + stats.free + stats.slack + stats.metadata + stats.fences == stats.footprint, "Funkcja heap_get_stats() powinna zwrócić składniki sumujące się do footprint");
+                test_error(stats.brk == custom_sbrk_get_reserved_memory(), "Funkcja heap_get_stats() powinna zwrócić brk równe %llu, a zwróciła %lu", custom_sbrk_get_reserved_memory(), stats.brk);
+
+                heap_free(p2);
+                p1 = heap_realloc(p1, 400);
+                test_error(p1 != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                status = heap_set_option(heap_option_mmap_threshold, 256 * 1024);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                char *large = heap_realloc(NULL, 1024 * 1024);
+                test_error(large != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_get_stats(&stats);
+                test_error(stats.allocated == 400 + 5000 + 1024 * 1024, "Funkcja heap_get_stats() powinna zwrócić allocated równe %lu, a zwróciła %lu", (size_t)400 + 5000 + 1024 * 1024, stats.allocated);
+                test_error(stats.mallocs == 4 && stats.frees == 1 && stats.reallocs == 1, "Funkcja heap_get_stats() powinna zwrócić liczniki 4/1/1, a zwróciła %lu/%lu/%lu", (size_t)stats.mallocs, (size_t)stats.frees, (size_t)stats.reallocs);
+                test_error(stats.free >= 1000, "Funkcja heap_get_stats() powinna uwzględnić zwolniony blok w free, a zwróciła %lu", stats.free);
+                test_error(stats.footprint >= stats.brk + 1024 * 1024, "Funkcja heap_get_stats() powinna uwzględnić duży blok w footprint");
+                test_error(stats.allocated + stats.free + stats.slack + stats.metadata + stats.fences == stats.footprint, "Funkcja heap_get_stats() powinna zwrócić składniki sumujące się do footprint");
+
+                heap_realloc(large, 0);
+                heap_set_option(heap_option_mmap_threshold, 0);
+                heap_free(p1);
+                heap_free(p3);
+
+                heap_get_stats(&stats);
+                test_error(stats.allocated == 0 && stats.fences == 0, "Funkcja heap_get_stats() powinna zwrócić allocated równe 0, a zwróciła %lu", stats.allocated);
+                test_error(stats.mallocs == 4 && stats.frees == 4, "Funkcja heap_get_stats() powinna zwrócić liczniki 4/4, a zwróciła %lu/%lu", (size_t)stats.mallocs, (size_t)stats.frees);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 152: Sprawdzanie histogramu przydziałów
+//
+void UTEST152(void)
+{
+    // informacje o teście
+    test_start(152, "Sprawdzanie histogramu przydziałów", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_histogram, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                test_error(heap_histogram_bucket_size(6) == 96, "Funkcja heap_histogram_bucket_size() powinna zwrócić 96, a zwróciła %lu", heap_histogram_bucket_size(6));
+                test_error(heap_histogram_bucket_size(19) == 448, "Funkcja heap_histogram_bucket_size() powinna zwrócić 448, a zwróciła %lu", heap_histogram_bucket_size(19));
+                test_error(heap_histogram_bucket_size(27) == 1792, "Funkcja heap_histogram_bucket_size() powinna zwrócić 1792, a zwróciła %lu", heap_histogram_bucket_size(27));
+                test_error(heap_histogram_bucket_size(HEAP_BIN_COUNT) == 0, "Funkcja heap_histogram_bucket_size() powinna zwrócić 0 dla przedziału spoza histogramu");
+
+                char *p1 = heap_malloc(100);
+                char *p2 = heap_calloc(10, 50);
+                char *p3 = heap_realloc(NULL, 100);
+                test_error(p1 != NULL && p2 != NULL && p3 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                p1 = heap_realloc(p1, 2000);
+                test_error(p1 != NULL, "Funkcja heap_realloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                struct heap_histogram_t histogram;
+                heap_get_histogram(&histogram);
+                test_error(histogram.sizes[6] == 2, "Funkcja heap_get_histogram() powinna zwrócić 2 przydziały w przedziale 6, a zwróciła %lu", (size_t)histogram.sizes[6]);
+                test_error(histogram.sizes[19] == 1, "Funkcja heap_get_histogram() powinna zwrócić 1 przydział w przedziale 19, a zwróciła %lu", (size_t)histogram.sizes[19]);
+                test_error(histogram.sizes[27] == 1, "Funkcja heap_get_histogram() powinna zwrócić 1 przydział w przedziale 27, a zwróciła %lu", (size_t)histogram.sizes[27]);
+
+                uint64_t total = 0;
+                for (int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+                    total += histogram.lifetimes[i];
+                test_error(total == 0, "Funkcja heap_get_histogram() powinna zwrócić 0 czasów życia przed zwolnieniem, a zwróciła %lu", (size_t)total);
+
+                heap_free(p1);
+                heap_free(p2);
+                heap_free(p3);
+
+                heap_get_histogram(&histogram);
+                total = 0;
+                for (int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+                    total += histogram.lifetimes[i];
+                test_error(total == 3, "Funkcja heap_get_histogram() powinna zwrócić 3 czasy życia, a zwróciła %lu", (size_t)total);
+
+                FILE *stream = fopen("histogram.txt", "w");
+                if (stream != NULL)
+                {
+                    heap_histogram_dump(stream);
+                    test_error(ftell(stream) > 0, "Funkcja heap_histogram_dump() powinna zapisać histogram do strumienia");
+                    fclose(stream);
+                    remove("histogram.txt");
+                }
+
+                status = heap_set_option(heap_option_histogram, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                p1 = heap_malloc(100);
+                heap_free(p1);
+                heap_get_histogram(&histogram);
+                test_error(histogram.sizes[6] == 2, "Funkcja heap_get_histogram() nie powinna liczyć przydziałów przy wyłączonym histogramie");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+// Bloki przydzielane i zwalniane przez osobne wątki (testy wielowątkowe)
+struct thread_blocks_t
+{
+    char *blocks[8];
+    size_t size;
+};
+
+static void* thread_blocks_alloc(void* arg)
+{
+    struct thread_blocks_t *data = (struct thread_blocks_t*)arg;
+    for (int i = 0; i < 8; ++i)
+    {
+        data->blocks[i] = heap_malloc(data->size);
+        if (data->blocks[i] != NULL)
+            memset(data->blocks[i], i, data->size);
+    }
+    return NULL;
+}
+
+static void* thread_blocks_free(void* arg)
+{
+    struct thread_blocks_t *data = (struct thread_blocks_t*)arg;
+    for (int i = 0; i < 8; ++i)
+        heap_free(data->blocks[i]);
+    return NULL;
+}
+
+//
+//  Test 153: Sprawdzanie aren wątków i zwalniania bloków wielu aren przez pamięć podręczną wątku
+//
+void UTEST153(void)
+{
+    // informacje o teście
+    test_start(153, "Sprawdzanie aren wątków i zwalniania bloków wielu aren przez pamięć podręczną wątku", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, HEAP_MAX_ARENAS);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_tcache, 4);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // dwa kolejne wątki dostają różne areny
+                struct thread_blocks_t first = { .size = 48 }, second = { .size = 48 };
+                pthread_t thread;
+                status = pthread_create(&thread, NULL, thread_blocks_alloc, &first);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                pthread_join(thread, NULL);
+                status = pthread_create(&thread, NULL, thread_blocks_alloc, &second);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                pthread_join(thread, NULL);
+
+                for (int i = 0; i < 8; ++i)
+                {
+                    test_error(first.blocks[i] != NULL && second.blocks[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                    test_error(get_pointer_type(first.blocks[i]) == pointer_valid && get_pointer_type(second.blocks[i]) == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić pointer_valid dla bloku przydzielonego w innym wątku");
+                }
+                intptr_t distance = (intptr_t)first.blocks[0] - (intptr_t)second.blocks[0];
+                test_error(distance > 1024 * 1024 || distance < -1024 * 1024, "Bloki wątków korzystających z różnych aren powinny leżeć w różnych obszarach pamięci");
+
+                // trzeci wątek zwalnia bloki obu aren przez swoją pamięć podręczną
+                struct thread_blocks_t both = { .size = 48 };
+                for (int i = 0; i < 4; ++i)
+                {
+                    both.blocks[2 * i] = first.blocks[i];
+                    both.blocks[2 * i + 1] = second.blocks[i];
+                }
+                status = pthread_create(&thread, NULL, thread_blocks_free, &both);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                pthread_join(thread, NULL);
+                for (int i = 0; i < 4; ++i)
+                {
+                    both.blocks[2 * i] = first.blocks[i + 4];
+                    both.blocks[2 * i + 1] = second.blocks[i + 4];
+                }
+                status = pthread_create(&thread, NULL, thread_blocks_free, &both);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                pthread_join(thread, NULL);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_set_option(heap_option_tcache, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_arenas, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+// Wątek przydzielający i zwalniający bloki na wspólnej arenie; liczy uszkodzone bloki i trafienia w pamięć podręczną
+struct thread_cache_t
+{
+    int tag;
+    int errors;
+    int hits;
+};
+
+static void* thread_cache_churn(void* arg)
+{
+    struct thread_cache_t *data = (struct thread_cache_t*)arg;
+    char *blocks[16] = { NULL };
+    for (int i = 0; i < 2000; ++i)
+    {
+        int slot = (i * 7) % 16;
+        if (blocks[slot] != NULL)
+        {
+            size_t size = 16 + (size_t)slot * 8;
+            for (size_t k = 0; k < size; ++k)
+                if (blocks[slot][k] != (char)(data->tag * 16 + slot))
+                    data->errors++;
+            char *released = blocks[slot];
+            heap_free(released);
+            blocks[slot] = heap_malloc(size);
+            if (blocks[slot] == released)
+                data->hits++;
+        }
+        else
+            blocks[slot] = heap_malloc(16 + (size_t)slot * 8);
+        if (blocks[slot] == NULL)
+        {
+            data->errors++;
+            continue;
+        }
+        memset(blocks[slot], data->tag * 16 + slot, 16 + (size_t)slot * 8);
+    }
+    for (int i = 0; i < 16; ++i)
+        heap_free(blocks[i]);
+    return NULL;
+}
+
+//
+//  Test 154: Sprawdzanie wielowątkowego przydzielania z pamięcią podręczną wątków
+//
+void UTEST154(void)
+{
+    // informacje o teście
+    test_start(154, "Sprawdzanie wielowątkowego przydzielania z pamięcią podręczną wątków", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_tcache, 4);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                struct thread_cache_t data[4];
+                pthread_t threads[4];
+                for (int i = 0; i < 4; ++i)
+                {
+                    data[i] = (struct thread_cache_t){ .tag = i };
+                    status = pthread_create(&threads[i], NULL, thread_cache_churn, &data[i]);
+                    test_error(status == 0, "Nie udało się uruchomić wątku");
+                }
+                for (int i = 0; i < 4; ++i)
+                    pthread_join(threads[i], NULL);
+
+                for (int i = 0; i < 4; ++i)
+                {
+                    test_error(data[i].errors == 0, "Wątek %d powinien odczytać niezmienione dane swoich bloków, a znalazł %d błędów", i, data[i].errors);
+                    test_error(data[i].hits > 1000, "Wątek %d powinien dostawać zwolnione bloki z własnej pamięci podręcznej, a dostał %d", i, data[i].hits);
+                }
+
+                // pamięć podręczna kończącego się wątku wraca na stertę
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_set_option(heap_option_tcache, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+// Blok przydzielony przez wątek właściciela i zwolniony przez wątek innej areny
+struct remote_free_t
+{
+    sem_t allocated;
+    sem_t freed;
+    char *block;
+    int pending;
+    int reused;
+};
+
+static void* remote_free_owner(void* arg)
+{
+    struct remote_free_t *data = (struct remote_free_t*)arg;
+    data->block = heap_malloc(200);
+    sem_post(&data->allocated);
+    sem_wait(&data->freed);
+    char *block = heap_malloc(200);
+    data->reused = block != NULL && block == data->block;
+    heap_free(block);
+    return NULL;
+}
+
+static void* remote_free_consumer(void* arg)
+{
+    struct remote_free_t *data = (struct remote_free_t*)arg;
+    sem_wait(&data->allocated);
+    char *own = heap_malloc(100);
+    heap_free(data->block);
+    // blok czeka na stosie areny właściciela, dopóki ten jej nie zajmie
+    data->pending = get_pointer_type(data->block) == pointer_valid;
+    heap_free(own);
+    sem_post(&data->freed);
+    return NULL;
+}
+
+//
+//  Test 155: Sprawdzanie zwalniania bloków obcej areny przez stos zwolnień
+//
+void UTEST155(void)
+{
+    // informacje o teście
+    test_start(155, "Sprawdzanie zwalniania bloków obcej areny przez stos zwolnień", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_arenas, HEAP_MAX_ARENAS);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_integrity, heap_integrity_free);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                struct remote_free_t data = { .block = NULL };
+                sem_init(&data.allocated, 0, 0);
+                sem_init(&data.freed, 0, 0);
+                pthread_t owner, consumer;
+                status = pthread_create(&owner, NULL, remote_free_owner, &data);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                status = pthread_create(&consumer, NULL, remote_free_consumer, &data);
+                test_error(status == 0, "Nie udało się uruchomić wątku");
+                pthread_join(consumer, NULL);
+                pthread_join(owner, NULL);
+                sem_destroy(&data.allocated);
+                sem_destroy(&data.freed);
+
+                test_error(data.block != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(data.pending, "Blok zwolniony przez wątek innej areny powinien trafić na stos zwolnień areny właściciela");
+                test_error(data.reused, "Wątek właściciela powinien ponownie dostać blok zwolniony przez inny wątek");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_set_option(heap_option_integrity, heap_integrity_full);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_arenas, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 156: Sprawdzanie, czy powtarzane przydzielanie dużego bloku nie zmienia za każdym razem rozmiaru sterty
+//
+void UTEST156(void)
+{
+    // informacje o teście
+    test_start(156, "Sprawdzanie, czy powtarzane przydzielanie dużego bloku nie zmienia za każdym razem rozmiaru sterty", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *small = heap_malloc(100);
+                test_error(small != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // każda zmiana zarezerwowanej pamięci to jedno wywołanie custom_sbrk
+                size_t sizes[] = { 120000, 200000 };
+                for (int k = 0; k < 2; ++k)
+                {
+                    int calls = 0;
+                    uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                    for (int i = 0; i < 100; ++i)
+                    {
+                        char *ptr = heap_malloc(sizes[k]);
+                        test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                        uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                        calls += reserved_after != reserved_memory;
+                        reserved_memory = reserved_after;
+
+                        heap_free(ptr);
+                        reserved_after = custom_sbrk_get_reserved_memory();
+                        calls += reserved_after != reserved_memory;
+                        reserved_memory = reserved_after;
+                    }
+                    test_error(calls <= 2, "Powtarzane przydzielanie i zwalnianie bloku %lu bajtów nie powinno za każdym razem zmieniać rozmiaru sterty, a zmieniło go %d razy", sizes[k], calls);
+                }
+
+                status = heap_trim(0);
+                test_error(status == 1, "Funkcja heap_trim() powinna zwrócić wartość 1, a zwróciła na %d", status);
+
+                uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                test_error(reserved_memory <= 8192, "Funkcja heap_trim() powinna oddać wolny koniec sterty, a zostało %llu bajtów", reserved_memory);
+
+                heap_free(small);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 157: Sprawdzanie geometrycznego powiększania sterty przy naprzemiennym przydzielaniu i zwalnianiu
+//
+void UTEST157(void)
+{
+    // informacje o teście
+    test_start(157, "Sprawdzanie geometrycznego powiększania sterty przy naprzemiennym przydzielaniu i zwalnianiu", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // sterta rośnie geometrycznie w pierwszej rundzie; w kolejnych zapas nie jest oddawany i odbudowywany
+                char *blocks[64];
+                for (int round = 0; round < 4; ++round)
+                {
+                    int grow = 0, shrink = 0;
+                    uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                    for (int i = 0; i < 64; ++i)
+                    {
+                        blocks[i] = heap_malloc(30000);
+                        test_error(blocks[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                        uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                        grow += reserved_after != reserved_memory;
+                        reserved_memory = reserved_after;
+                    }
+                    for (int i = 63; i >= 0; --i)
+                    {
+                        heap_free(blocks[i]);
+                        uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                        shrink += reserved_after != reserved_memory;
+                        reserved_memory = reserved_after;
+                    }
+                    test_error(grow <= (round == 0 ? 8 : 2), "W rundzie %d sterta powinna urosnąć najwyżej %d razy, a urosła %d razy", round, round == 0 ? 8 : 2, grow);
+                    test_error(shrink <= 2, "W rundzie %d sterta powinna zostać zmniejszona najwyżej 2 razy, a została %d razy", round, shrink);
+                }
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 158: Sprawdzanie wolnego bloku przed wyrównanym blokiem i wyrównanego przydziału z koszyka
+//
+void UTEST158(void)
+{
+    // informacje o teście
+    test_start(158, "Sprawdzanie wolnego bloku przed wyrównanym blokiem i wyrównanego przydziału z koszyka", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // pierwszy blok wyrównany, więc przerwy przed blokami mają znany rozmiar
+                char *small = heap_memalign(65536, 100);
+                test_error(small != NULL, "Funkcja heap_memalign() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // przerwa przed blokiem wyrównanym na końcu sterty staje się wolnym blokiem
+                char *aligned = heap_memalign(65536, 100);
+                test_error(aligned != NULL, "Funkcja heap_memalign() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(((intptr_t)aligned & 65535) == 0, "Funkcja heap_memalign() powinna zwrócić adres wyrównany do 65536 bajtów");
+
+                size_t largest = heap_get_largest_free_block_size();
+                test_error(largest >= 60000 && largest < 65536, "Funkcja heap_get_largest_free_block_size() powinna zwrócić rozmiar przerwy przed wyrównanym blokiem, a zwróciła %lu", largest);
+
+                char *ptr = heap_malloc(30000);
+                test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(ptr < aligned, "Funkcja heap_malloc() powinna przydzielić blok z przerwy przed wyrównanym blokiem");
+
+                // zwolniony blok z koszyka wystarcza na kolejny wyrównany przydział
+                heap_free(ptr);
+                char *aligned2 = heap_memalign(4096, 1000);
+                test_error(aligned2 != NULL, "Funkcja heap_memalign() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(((intptr_t)aligned2 & 4095) == 0, "Funkcja heap_memalign() powinna zwrócić adres wyrównany do 4096 bajtów");
+                test_error(aligned2 < aligned, "Funkcja heap_memalign() powinna przydzielić blok z wolnego bloku przed wyrównanym blokiem");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(aligned2);
+                heap_free(aligned);
+                heap_free(small);
+
+                largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %lu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 159: Sprawdzanie niezgodnego rozmiaru i podwójnego zwolnienia w heap_free_sized
+//
+void UTEST159(void)
+{
+    // informacje o teście
+    test_start(159, "Sprawdzanie niezgodnego rozmiaru i podwójnego zwolnienia w heap_free_sized", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // bez pełnej kontroli integralności heap_free_sized zwalnia duży blok wprost przez nagłówek
+                status = heap_set_option(heap_option_integrity, heap_integrity_off);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_mmap_threshold, 65536);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *small = heap_malloc(100);
+                char *large = heap_malloc(100000);
+                test_error(small != NULL && large != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // niezgodny rozmiar zostawia blok przydzielony
+                heap_free_sized(small, 1000);
+                test_error(typ_pointer == pointer_heap_corrupted, "Funkcja heap_free_sized() powinna ustawić typ_pointer na pointer_heap_corrupted, a ustawiła %d", typ_pointer);
+                status = get_pointer_type(small);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                heap_free_sized(large, 99999);
+                test_error(typ_pointer == pointer_heap_corrupted, "Funkcja heap_free_sized() powinna ustawić typ_pointer na pointer_heap_corrupted, a ustawiła %d", typ_pointer);
+                status = get_pointer_type(large);
+                test_error(status == pointer_valid, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_valid, a zwróciła na %d", status);
+
+                heap_free_sized(small, 100);
+                heap_free_sized(large, 100000);
+                test_error(typ_pointer == pointer_valid, "Funkcja heap_free_sized() powinna ustawić typ_pointer na pointer_valid, a ustawiła %d", typ_pointer);
+
+                // podwójne zwolnienie dużego bloku nie czyta odmapowanego nagłówka
+                heap_free_sized(large, 100000);
+                test_error(typ_pointer != pointer_valid, "Funkcja heap_free_sized() nie powinna przyjąć ponownego zwolnienia dużego bloku");
+                status = get_pointer_type(large);
+                test_error(status == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_mmap_threshold, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                status = heap_set_option(heap_option_integrity, heap_integrity_full);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 160: Sprawdzanie zwrotu bloków serii po wykryciu uszkodzenia sterty
+//
+void UTEST160(void)
+{
+    // informacje o teście
+    test_start(160, "Sprawdzanie zwrotu bloków serii po wykryciu uszkodzenia sterty", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr = heap_malloc(100);
+                test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // uszkodzony płotek wykrywa kontrola serii już po wycięciu bloków
+                ptr[100] = 'x';
+                void *ptrs[16];
+                size_t count = heap_malloc_batch(48, 16, ptrs);
+                test_error(count == 0, "Funkcja heap_malloc_batch() powinna zwrócić 0 dla uszkodzonej sterty, a zwróciła %zu", count);
+                test_error(typ_pointer == pointer_heap_corrupted, "Funkcja heap_malloc_batch() powinna ustawić typ_pointer na pointer_heap_corrupted, a ustawiła %d", typ_pointer);
+                ptr[100] = '#';
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // wycięte bloki wróciły do sterty
+                struct heap_stats_t stats;
+                heap_get_stats(&stats);
+                test_error(stats.allocated == 100, "Funkcja heap_get_stats() powinna zwrócić 100 bajtów zajętych, a zwróciła %zu", stats.allocated);
+
+                count = heap_malloc_batch(48, 16, ptrs);
+                test_error(count == 16, "Funkcja heap_malloc_batch() powinna przydzielić 16 bloków, a przydzieliła %zu", count);
+
+                heap_free_batch(ptrs, count);
+                heap_free(ptr);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 161: Sprawdzanie wyłączania i ponownego włączania histogramu
+//
+void UTEST161(void)
+{
+    // informacje o teście
+    test_start(161, "Sprawdzanie wyłączania i ponownego włączania histogramu", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                status = heap_set_option(heap_option_histogram, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *p1 = heap_malloc(100);
+                char *p2 = heap_malloc(200);
+                test_error(p1 != NULL && p2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // przy wyłączonym histogramie zwolnienie nie zagląda do próbek
+                status = heap_set_option(heap_option_histogram, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                heap_free(p1);
+
+                struct heap_histogram_t histogram;
+                heap_get_histogram(&histogram);
+                uint64_t total = 0;
+                for (int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+                    total += histogram.lifetimes[i];
+                test_error(total == 0, "Funkcja heap_get_histogram() powinna zwrócić 0 czasów życia przy wyłączonym histogramie, a zwróciła %lu", (size_t)total);
+
+                // ponowne włączenie zaczyna próbki od nowa - p2 sprzed wyłączenia nie jest już próbką
+                status = heap_set_option(heap_option_histogram, 1);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                heap_free(p2);
+
+                char *p3 = heap_malloc(300);
+                test_error(p3 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                heap_free(p3);
+
+                heap_get_histogram(&histogram);
+                total = 0;
+                for (int i = 0; i < HEAP_LIFETIME_BUCKETS; i++)
+                    total += histogram.lifetimes[i];
+                test_error(total == 1, "Funkcja heap_get_histogram() powinna zwrócić 1 czas życia po ponownym włączeniu, a zwróciła %lu", (size_t)total);
+
+                status = heap_set_option(heap_option_histogram, 0);
+                test_error(status == 0, "Funkcja heap_set_option() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 162: Sprawdzanie oddania końca sterty po zwolnieniu bloku większego niż przyrost
+//
+void UTEST162(void)
+{
+    // informacje o teście
+    test_start(162, "Sprawdzanie oddania końca sterty po zwolnieniu bloku większego niż przyrost", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *small = heap_malloc(100);
+                test_error(small != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                char *big = heap_malloc(20 * 1024 * 1024);
+                test_error(big != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                uint64_t reserved = custom_sbrk_get_reserved_memory();
+                test_error(reserved >= 20 * 1024 * 1024, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić co najmniej 20 MB, a zwróciła %llu", reserved);
+
+                // próg oddawania nie rośnie do rozmiaru dużego bloku, więc koniec sterty wraca od razu
+                heap_free(big);
+                reserved = custom_sbrk_get_reserved_memory();
+                test_error(reserved < 2 * 1024 * 1024, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić mniej niż 2 MB po zwolnieniu dużego bloku, a zwróciła %llu", reserved);
+
+                // kolejne przydziały i zwolnienia nie przywracają szczytowego rozmiaru sterty
+                for (int i = 0; i < 16; i++) {
+                    char *ptr = heap_malloc(1000 + i * 5000);
+                    test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                    heap_free(ptr);
+                }
+                heap_free(small);
+                reserved = custom_sbrk_get_reserved_memory();
+                test_error(reserved < 2 * 1024 * 1024, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić mniej niż 2 MB po opróżnieniu sterty, a zwróciła %llu", reserved);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 163: Sprawdzanie wykrywania zamiany i zmiany pól nagłówka przez sumę kontrolną z kluczem
+//
+void UTEST163(void)
+{
+    // informacje o teście
+    test_start(163, "Sprawdzanie wykrywania zamiany i zmiany pól nagłówka przez sumę kontrolną z kluczem", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *ptr = heap_malloc(200);
+                char *ptr1 = heap_malloc(103);
+                char *ptr2 = heap_malloc(300);
+                test_error(ptr != NULL && ptr1 != NULL && ptr2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // nagłówek bloku kończy się tuż przed płotkiem
+                int i = -1;
+                while (get_pointer_type(ptr1 + i) == pointer_inside_fences) --i;
+                test_error(get_pointer_type(ptr1 + i) == pointer_control_block, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_control_block dla bajtu przed płotkiem");
+                struct memory_chunk_t *block = (struct memory_chunk_t *)(ptr1 + i + 1 - sizeof(struct memory_chunk_t));
+                struct memory_chunk_t saved = *block;
+                test_error(saved.prev_size != saved.size && saved.span != saved.size, "Pola nagłówka powinny mieć różne wartości");
+
+                // zamiana pól miejscami i zmiany znoszące się w sumie bajtów nie mogą przejść niezauważone
+                for (int k = 0; k < 5; k++)
+                {
+                    uint32_t temp;
+                    switch (k)
+                    {
+                        case 0: temp = block->prev_size; block->prev_size = block->size; block->size = temp; break;
+                        case 1: temp = block->span; block->span = block->size; block->size = temp; break;
+                        case 2: block->span ^= 1; break;
+                        case 3: block->size += 16; block->prev_size -= 16; break;
+                        case 4: ((uint8_t *)block)[0] += 1; ((uint8_t *)block)[9] -= 1; break;
+                    }
+
+                    status = heap_validate();
+                    test_error(status == 3, "Funkcja heap_validate() powinna zwrócić wartość 3 dla zmienionego nagłówka (przypadek %d), a zwróciła na %d", k, status);
+                    test_error(get_pointer_type(ptr1) == pointer_heap_corrupted, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_heap_corrupted (przypadek %d), a zwróciła %d", k, get_pointer_type(ptr1));
+
+                    *block = saved;
+
+                    status = heap_validate();
+                    test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+                }
+
+                // nagłówek przeniesiony z innego bloku ma poprawną sumę tylko dla swoich pól
+                struct memory_chunk_t *block2 = (struct memory_chunk_t *)((uint8_t *)block + (ptr2 - ptr1));
+                struct memory_chunk_t saved2 = *block2;
+                *block2 = saved;
+                block2->prev_size = saved2.prev_size;
+                status = heap_validate();
+                test_error(status == 3, "Funkcja heap_validate() powinna zwrócić wartość 3 dla nagłówka skopiowanego z innego bloku, a zwróciła na %d", status);
+                *block2 = saved2;
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(ptr);
+                heap_free(ptr1);
+                heap_free(ptr2);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 164: Sprawdzanie ponownego użycia reszty po podziale wolnego bloku
+//
+void UTEST164(void)
+{
+    // informacje o teście
+    test_start(164, "Sprawdzanie ponownego użycia reszty po podziale wolnego bloku", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // blok za dużym blokiem nie pozwala oddać go razem z końcem sterty
+                char *big = heap_malloc(100000);
+                char *guard = heap_malloc(100);
+                test_error(big != NULL && guard != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                heap_free(big);
+
+                uint64_t reserved = custom_sbrk_get_reserved_memory();
+
+                // mniejsze bloki mieszczą się w reszcie po podziale wolnego bloku
+                char *ptr[3];
+                for (int i = 0; i < 3; ++i)
+                {
+                    ptr[i] = heap_malloc(30000);
+                    test_error(ptr[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                    test_error(ptr[i] >= big && ptr[i] + 30000 <= big + 100000, "Funkcja heap_malloc() powinna przydzielić blok %d z reszty zwolnionego bloku", i);
+                    memset(ptr[i], i + 1, 30000);
+                }
+
+                uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                test_error(reserved_after == reserved, "Sterta nie powinna się powiększyć przy przydziale z reszty wolnego bloku (%llu, a było %llu)", reserved_after, reserved);
+
+                // po trzech podziałach zostaje jeszcze wolny blok na kolejny przydział
+                char *rest = heap_malloc(9000);
+                test_error(rest != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(rest >= big && rest + 9000 <= big + 100000, "Funkcja heap_malloc() powinna przydzielić blok z ostatniej reszty zwolnionego bloku");
+                test_error(custom_sbrk_get_reserved_memory() == reserved, "Sterta nie powinna się powiększyć przy przydziale z reszty wolnego bloku");
+                test_error(unused_size(ptr[0]) == 0, "Funkcja unused_size() powinna zwrócić 0 dla bloku z podziału, a zwróciła %d", unused_size(ptr[0]));
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                for (int i = 0; i < 3; ++i)
+                    heap_free(ptr[i]);
+                heap_free(rest);
+                heap_free(guard);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 165: Sprawdzanie przydziału z koszyka klasy rozmiaru przy wielu zajętych blokach
+//
+void UTEST165(void)
+{
+    // informacje o teście
+    test_start(165, "Sprawdzanie przydziału z koszyka klasy rozmiaru przy wielu zajętych blokach", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // duży wolny blok na początku sterty, przed nim i za nim bloki zajęte
+                char *guard = heap_malloc(100);
+                char *big = heap_malloc(5000);
+                test_error(guard != NULL && big != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                // wiele zajętych bloków między wolnymi blokami
+                const int count = 10000;
+                char **live = (char **)heap_malloc(sizeof(char *) * count);
+                test_error(live != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                for (int i = 0; i < count; ++i)
+                {
+                    live[i] = heap_malloc(32 + i % 7 * 16);
+                    test_error(live[i] != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                }
+
+                // mały wolny blok za zajętymi blokami
+                char *small = heap_malloc(200);
+                char *guard2 = heap_malloc(100);
+                test_error(small != NULL && guard2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                heap_free(big);
+                heap_free(small);
+
+                // przydział z koszyka klasy rozmiaru trafia w mały blok, a nie w pierwszy pasujący od początku sterty
+                char *ptr = heap_malloc(200);
+                test_error(ptr == small, "Funkcja heap_malloc() powinna przydzielić blok z koszyka jego klasy rozmiaru (%p), a zwróciła %p", (void *)small, (void *)ptr);
+
+                char *ptr2 = heap_calloc(1, 4000);
+                test_error(ptr2 == big, "Funkcja heap_calloc() powinna przydzielić blok z wolnego bloku na początku sterty (%p), a zwróciła %p", (void *)big, (void *)ptr2);
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                for (int i = 0; i < count; ++i)
+                    heap_free(live[i]);
+                heap_free(live);
+                heap_free(ptr);
+                heap_free(ptr2);
+                heap_free(guard);
+                heap_free(guard2);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 166: Sprawdzanie scalania zwolnionego bloku z wolnymi sąsiadami przez znaczniki rozmiaru
+//
+void UTEST166(void)
+{
+    // informacje o teście
+    test_start(166, "Sprawdzanie scalania zwolnionego bloku z wolnymi sąsiadami przez znaczniki rozmiaru", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                char *guard = heap_malloc(100);
+                char *ptr1 = heap_malloc(1000);
+                char *ptr2 = heap_malloc(2000);
+                char *ptr3 = heap_malloc(3000);
+                char *guard2 = heap_malloc(100);
+                test_error(guard != NULL && ptr1 != NULL && ptr2 != NULL && ptr3 != NULL && guard2 != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                struct heap_stats_t stats;
+                heap_get_stats(&stats);
+                size_t chunks = stats.chunks;
+
+                // sąsiedzi zajęci - bez scalania
+                heap_free(ptr1);
+                heap_free(ptr3);
+                heap_get_stats(&stats);
+                test_error(stats.chunks == chunks, "Funkcja heap_get_stats() powinna zwrócić %zu bloków, a zwróciła %zu", chunks, stats.chunks);
+
+                // środkowy blok łączy się z wolnymi sąsiadami po obu stronach
+                heap_free(ptr2);
+                heap_get_stats(&stats);
+                test_error(stats.chunks == chunks - 2, "Funkcja heap_get_stats() powinna zwrócić %zu bloków po scaleniu, a zwróciła %zu", chunks - 2, stats.chunks);
+
+                // znacznik rozmiaru poprzednika w nagłówku za scalonym blokiem obejmuje cały scalony blok
+                int i = -1;
+                while (get_pointer_type(guard2 + i) == pointer_inside_fences) --i;
+                struct memory_chunk_t *next = (struct memory_chunk_t *)(guard2 + i + 1 - sizeof(struct memory_chunk_t));
+                struct memory_chunk_t *merged = (struct memory_chunk_t *)((uint8_t *)next - next->prev_size);
+                test_error((uint8_t *)merged < (uint8_t *)ptr1 && (uint8_t *)ptr1 - (uint8_t *)merged <= 64, "Pole prev_size bloku za scalonym blokiem powinno wskazywać nagłówek pierwszego zwolnionego bloku");
+                test_error(get_pointer_type(ptr1) == pointer_unallocated && get_pointer_type(ptr3) == pointer_unallocated, "Funkcja get_pointer_type() powinna zwrócić wartość pointer_unallocated dla scalonego bloku");
+
+                // scalony blok mieści przydział większy niż każdy ze zwolnionych bloków
+                char *ptr = heap_malloc(6000);
+                test_error(ptr != NULL && ptr >= ptr1 && ptr < guard2, "Funkcja heap_malloc() powinna przydzielić blok ze scalonych bloków");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(ptr);
+                heap_free(guard);
+                heap_free(guard2);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 167: Sprawdzanie wyrównania bloków do 16 bajtów i 16-bajtowego nagłówka
+//
+void UTEST167(void)
+{
+    // informacje o teście
+    test_start(167, "Sprawdzanie wyrównania bloków do 16 bajtów i 16-bajtowego nagłówka", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                test_error(sizeof(struct memory_chunk_t) == 16, "Nagłówek bloku powinien zajmować 16 bajtów, a zajmuje %zu", sizeof(struct memory_chunk_t));
+
+                // nagłówek zajętego bloku to 16 bajtów bloku kontrolnego przed płotkiem
+                char *a = heap_malloc(16);
+                char *b = heap_malloc(16);
+                test_error(a != NULL && b != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                int i = -1;
+                while (get_pointer_type(b + i) == pointer_inside_fences) --i;
+                int fence = -1 - i;
+                int control = 0;
+                while (get_pointer_type(b + i - control) == pointer_control_block) ++control;
+                test_error(control == 16, "Blok kontrolny powinien zajmować 16 bajtów, a zajmuje %d", control);
+
+                // mały blok kosztuje tylko nagłówek i dwa płotki
+                test_error(b - a == control + 16 + 2 * fence, "Odstęp między kolejnymi małymi blokami powinien wynosić %d bajtów, a wynosi %ld", control + 16 + 2 * fence, (long)(b - a));
+
+                // bloki o rozmiarach niebędących wielokrotnością 16 nie psują wyrównania kolejnych bloków
+                char *ptr[100];
+                for (int k = 0; k < 100; ++k)
+                {
+                    size_t size = 1 + (size_t)k * 13;
+                    ptr[k] = k % 3 == 0 ? heap_calloc(1, size) : k % 3 == 1 ? heap_malloc(size) : heap_realloc(NULL, size);
+                    test_error(ptr[k] != NULL, "Funkcja przydzielająca powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                    test_error(((intptr_t)ptr[k] & 15) == 0, "Adres bloku %d powinien być wyrównany do 16 bajtów (%p)", k, (void *)ptr[k]);
+                    test_error(((intptr_t)ptr[k] & (_Alignof(max_align_t) - 1)) == 0, "Adres bloku %d powinien być wyrównany do max_align_t", k);
+                }
+
+                // zmniejszanie i powiększanie zachowuje wyrównanie
+                for (int k = 0; k < 100; k += 2)
+                {
+                    ptr[k] = heap_realloc(ptr[k], 7 + (size_t)k * 29);
+                    test_error(ptr[k] != NULL && ((intptr_t)ptr[k] & 15) == 0, "Funkcja heap_realloc() powinna zwrócić adres wyrównany do 16 bajtów");
+                }
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                for (int k = 0; k < 100; ++k)
+                    heap_free(ptr[k]);
+                heap_free(a);
+                heap_free(b);
+
+                size_t largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
+//
+//  Test 168: Sprawdzanie wolnego końca sterty w heap_get_largest_free_block_size()
+//
+void UTEST168(void)
+{
+    // informacje o teście
+    test_start(168, "Sprawdzanie wolnego końca sterty w heap_get_largest_free_block_size()", __LINE__);
+
+    // uwarunkowanie zasobów - pamięci, itd...
+    test_file_write_limit_setup(33554432);
+    rldebug_reset_limits();
+    
+    //
+    // -----------
+    //
+    
+                int status = heap_setup();
+                test_error(status == 0, "Funkcja heap_setup() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                // sterta rośnie z zapasem, który zostaje wolnym końcem sterty za ostatnim blokiem
+                char *ptr = heap_malloc(100);
+                test_error(ptr != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+
+                uint64_t reserved = custom_sbrk_get_reserved_memory();
+                size_t largest = heap_get_largest_free_block_size();
+                test_error(largest > 0 && largest < reserved, "Funkcja heap_get_largest_free_block_size() powinna zwrócić pojemność wolnego końca sterty, a zwróciła na %zu", largest);
+
+                // blok o zwróconym rozmiarze mieści się w końcu sterty bez jej powiększania
+                char *tail = heap_malloc(largest);
+                test_error(tail != NULL && tail > ptr, "Funkcja heap_malloc() powinna przydzielić blok w wolnym końcu sterty");
+                uint64_t reserved_after = custom_sbrk_get_reserved_memory();
+                test_error(reserved_after == reserved, "Sterta nie powinna się powiększyć przy przydziale bloku o rozmiarze zwróconym przez heap_get_largest_free_block_size() (%llu, a było %llu)", reserved_after, reserved);
+
+                size_t rest = heap_get_largest_free_block_size();
+                test_error(rest == 0, "Funkcja heap_get_largest_free_block_size() powinna zwrócić wartość 0 po zajęciu końca sterty, a zwróciła na %zu", rest);
+
+                // o bajt większy blok wymaga już powiększenia sterty
+                heap_free(tail);
+                tail = heap_malloc(largest + 1);
+                test_error(tail != NULL, "Funkcja heap_malloc() powinna zwrócić adres przydzielonego bloku pamięci, a zwróciła NULL");
+                test_error(custom_sbrk_get_reserved_memory() > reserved, "Sterta powinna się powiększyć przy przydziale bloku większego niż wolny koniec sterty");
+
+                status = heap_validate();
+                test_error(status == 0, "Funkcja heap_validate() powinna zwrócić wartość 0, a zwróciła na %d", status);
+
+                heap_free(tail);
+                heap_free(ptr);
+
+                largest = heap_get_largest_used_block_size();
+                test_error(largest == 0, "Funkcja heap_get_largest_used_block_size() powinna zwrócić wartość 0, a zwróciła na %zu", largest);
+
+                 status = custom_sbrk_check_fences_integrity();
+                 test_error(status == 0, "Funkcja custom_sbrk_check_fences_integrity() powinna zwrócić wartość 0, a zwróciła na %d. Oznacza to, że alokator nadpisał pamięć, która nie została przydzielona przez system", status);
+
+                 heap_clean();
+
+                 uint64_t reserved_memory = custom_sbrk_get_reserved_memory();
+                 test_error(reserved_memory == 0, "Funkcja custom_sbrk_get_reserved_memory() powinna zwrócić wartość 0, a zwróciła na %llu. Po wywołaniu funkcji heap_clean cała pamięć zarezerwowana przez alokator powinna być zwrócona do systemu", reserved_memory);
+                        
+    //
+    // -----------
+    //
+
+    // przywrócenie podstawowych parametów przydzielania zasobów (jeśli to tylko możliwe)
+    rldebug_reset_limits();
+    test_file_write_limit_restore();
+    
+    test_ok();
+}
+
 
 
 
@@ -8632,6 +11445,41 @@ int __wrap_main(volatile int _argc, char** _argv, char** _envp)
             UTEST131, // Sprawdzanie poprawności działania funkcji heap_realloc_aligned - test sprawdza poprawność działania funkcji w przypadku żądania większego rozmiaru pamięci, który zajmował poprzednio
             UTEST132, // Sprawdzanie poprawności działania funkcji heap_realloc_aligned
             UTEST133, // Sprawdzanie poprawności działania funkcji wszystkich funkcji alokujących pamięć
+            UTEST134, // Sprawdzanie poprawności działania funkcji heap_set_option - test sprawdza poprawność działania funkcji alokujących przy obniżonym poziomie kontroli sterty
+            UTEST135, // Sprawdzanie poprawności działania funkcji heap_malloc i heap_free z pamięcią podręczną wątku
+            UTEST136, // Sprawdzanie poprawności działania funkcji heap_set_option dla liczby aren
+            UTEST137, // Sprawdzanie poprawności działania slabów dla małych obiektów
+            UTEST138, // Sprawdzanie poprawności działania regionów heap_arena_create, heap_arena_alloc, heap_arena_reset i heap_arena_destroy
+            UTEST139, // Sprawdzanie poprawności działania silnika TLSF
+            UTEST140, // Sprawdzanie poprawności działania dużych bloków w osobnych mapowaniach
+            UTEST141, // Sprawdzanie poprawności oddawania wolnego końca sterty
+            UTEST142, // Sprawdzanie poprawności geometrycznego powiększania sterty
+            UTEST143, // Sprawdzanie poprawności zmiany rozmiaru bloku w miejscu
+            UTEST144, // Sprawdzanie poprawności działania funkcji heap_memalign dla różnych wyrównań
+            UTEST145, // Sprawdzanie poprawności działania funkcji heap_calloc dla nowej i ponownie używanej pamięci
+            UTEST146, // Sprawdzanie poprawności przydzielania i zwalniania bloków seriami
+            UTEST147, // Sprawdzanie poprawności działania funkcji heap_free_sized
+            UTEST148, // Sprawdzanie poprawności klasyfikacji wskaźników przez mapę stron
+            UTEST149, // Sprawdzanie funkcji heap_validate_step() i walidacji w tle
+            UTEST150, // Sprawdzanie funkcji heap_get_largest_used_block_size() i heap_get_largest_free_block_size()
+            UTEST151, // Sprawdzanie funkcji heap_get_stats()
+            UTEST152, // Sprawdzanie histogramu przydziałów
+            UTEST153, // Sprawdzanie aren wątków i zwalniania bloków wielu aren przez pamięć podręczną wątku
+            UTEST154, // Sprawdzanie wielowątkowego przydzielania z pamięcią podręczną wątków
+            UTEST155, // Sprawdzanie zwalniania bloków obcej areny przez stos zwolnień
+            UTEST156, // Sprawdzanie, czy powtarzane przydzielanie dużego bloku nie zmienia za każdym razem rozmiaru sterty
+            UTEST157, // Sprawdzanie geometrycznego powiększania sterty przy naprzemiennym przydzielaniu i zwalnianiu
+            UTEST158, // Sprawdzanie wolnego bloku przed wyrównanym blokiem i wyrównanego przydziału z koszyka
+            UTEST159, // Sprawdzanie niezgodnego rozmiaru i podwójnego zwolnienia w heap_free_sized
+            UTEST160, // Sprawdzanie zwrotu bloków serii po wykryciu uszkodzenia sterty
+            UTEST161, // Sprawdzanie wyłączania i ponownego włączania histogramu
+            UTEST162, // Sprawdzanie oddania końca sterty po zwolnieniu bloku większego niż przyrost
+            UTEST163, // Sprawdzanie wykrywania zamiany i zmiany pól nagłówka przez sumę kontrolną z kluczem
+            UTEST164, // Sprawdzanie ponownego użycia reszty po podziale wolnego bloku
+            UTEST165, // Sprawdzanie przydziału z koszyka klasy rozmiaru przy wielu zajętych blokach
+            UTEST166, // Sprawdzanie scalania zwolnionego bloku z wolnymi sąsiadami przez znaczniki rozmiaru
+            UTEST167, // Sprawdzanie wyrównania bloków do 16 bajtów i 16-bajtowego nagłówka
+            UTEST168, // Sprawdzanie wolnego końca sterty w heap_get_largest_free_block_size()
             NULL
         };
 
@@ -8654,7 +11502,7 @@ int __wrap_main(volatile int _argc, char** _argv, char** _envp)
         // poinformuj serwer Mrówka o wyniku testu - podsumowanie
         test_title("Podsumowanie");
         if (selected_test == -1)
-            test_summary(133); // wszystkie testy muszą zakończyć się sukcesem
+            test_summary(168); // wszystkie testy muszą zakończyć się sukcesem
         else
             test_summary(1); // tylko jeden (selected_test) test musi zakończyć się  sukcesem
         return EXIT_SUCCESS;